@@ -0,0 +1,139 @@
+#ifndef BOARD_GRID_H
+#define BOARD_GRID_H
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "DrawableBoard.hpp"
+
+/**
+ * Grid of boards shown in one window (a simul, or every game of a broadcast round)
+ * Every board is rendered into its own texture only when it changed, drawing the grid is then one sprite per board
+ * The boards share the peice atlas, so dozens of boards cost one set of peice images
+ */
+class BoardGrid : public sf::Drawable
+{
+public:
+    /**
+     * @param boards number of boards
+     * @param columns boards per row
+     * @param squareSize side length of a square of every board in pixels
+     * @param spacing gap between the boards and around the grid in pixels
+     */
+    BoardGrid(int boards, int columns, float squareSize, float spacing)
+    {
+        this->columns = std::max(1, columns);
+        this->spacing = spacing;
+        boardSize = 8 * squareSize;
+        unsigned textureSize = static_cast<unsigned>(std::ceil(boardSize));
+
+        for (int i = 0; i < boards; ++i) {
+            // boards draw at the origin of their own texture, the sprite places them in the grid
+            cells.push_back(std::make_unique<Cell>(sf::Vector2f(0, 0), squareSize));
+            Cell &cell = *cells.back();
+            cell.texture.create(textureSize, textureSize);
+            cell.sprite.setTexture(cell.texture.getTexture(), true);
+            cell.sprite.setPosition(cellPosition(i));
+        }
+    }
+
+    int size() const noexcept
+    {
+        return static_cast<int>(cells.size());
+    }
+
+    DrawableBoard &board(int index)
+    {
+        return cells[index]->board;
+    }
+
+    // pixel size of the whole grid (the window size that fits it)
+    sf::Vector2u pixelSize() const
+    {
+        int rows = (size() + columns - 1) / columns;
+        int shownColumns = std::min(columns, size());
+        return sf::Vector2u(static_cast<unsigned>(std::ceil(shownColumns * (boardSize + spacing) + spacing)),
+                            static_cast<unsigned>(std::ceil(rows * (boardSize + spacing) + spacing)));
+    }
+
+    // index of the board under the given window position, -1 if there is none
+    int boardAt(sf::Vector2f position) const
+    {
+        for (int i = 0; i < size(); ++i) {
+            sf::Vector2f relative = position - cellPosition(i);
+            if (relative.x >= 0 && relative.y >= 0 && relative.x < boardSize && relative.y < boardSize) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // window position in the coordinates of the given board (for forwarding mouse input)
+    sf::Vector2f toBoard(int index, sf::Vector2f position) const
+    {
+        return position - cellPosition(index) + cells[index]->board.getPosition();
+    }
+
+    // true if a board changed since its texture was last rendered
+    bool needsRedraw() const noexcept
+    {
+        for (const auto &cell : cells) {
+            if (cell->board.needsRedraw()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Render the boards that changed into their textures (the others keep their last rendering)
+    void render()
+    {
+        for (auto &cell : cells) {
+            if (cell->board.needsRedraw()) {
+                cell->texture.clear();
+                cell->texture.draw(cell->board);
+                cell->texture.display();
+                cell->board.markDrawn();
+            }
+        }
+    }
+
+private:
+    struct Cell
+    {
+        Cell(sf::Vector2f position, float squareSize) : board(position, true, squareSize) {}
+
+        DrawableBoard board;
+
+        sf::RenderTexture texture;
+
+        sf::Sprite sprite;
+    };
+
+    // cells are not movable (the sprite points at the texture)
+    std::vector<std::unique_ptr<Cell>> cells;
+
+    int columns;
+
+    float spacing;
+
+    float boardSize;
+
+    // top left corner of the board with the given index in window coordinates
+    sf::Vector2f cellPosition(int index) const
+    {
+        return sf::Vector2f(spacing + (index % columns) * (boardSize + spacing), spacing + (index / columns) * (boardSize + spacing));
+    }
+
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const
+    {
+        for (const auto &cell : cells) {
+            target.draw(cell->sprite, states);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,179 @@
+#ifndef ENGINE_THREAD_H
+#define ENGINE_THREAD_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "ParallelSearch.hpp"
+#include "Position.hpp"
+#include "TranspositionTable.hpp"
+
+/**
+ * Runs the search on a worker thread so the caller (the gui thread) never blocks on it
+ * Requests carry a snapshot of the position, results are posted back as updates that the caller drains with poll
+ * Every request gets an id so updates of a cancelled or replaced request can be told apart from the current one
+ */
+class EngineThread
+{
+public:
+    // Result of an iteration of the search, or the final result of a request
+    struct Update
+    {
+        // id returned by the request that produced this update
+        int request;
+
+        // true for the last update of a request (info holds the final result)
+        bool finished;
+
+        SearchInfo info;
+    };
+
+    /**
+     * @param hashMegabytes size of the transposition table
+     * @param threads number of search threads (0 uses the number of hardware threads)
+     */
+    explicit EngineThread(std::size_t hashMegabytes = 16, int threads = 1)
+        : tt(hashMegabytes), search(tt, threads), nextRequest(0), running(false), quitting(false)
+    {
+        worker = std::thread(&EngineThread::run, this);
+    }
+
+    EngineThread(const EngineThread &) = delete;
+    EngineThread &operator=(const EngineThread &) = delete;
+
+    // Cancels any running search and joins the worker
+    ~EngineThread()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quitting = true;
+            pending.reset();
+        }
+        search.stop();
+        wake.notify_all();
+        worker.join();
+    }
+
+    /**
+     * Start searching the given position, cancelling the running search (if any)
+     * @param position snapshot of the position to search (copied, may be changed right after the call)
+     * @param limits search limits (no limits searches until cancelled)
+     * @return id of the request, used in its updates
+     */
+    int startSearch(const Position &position, const SearchLimits &limits)
+    {
+        int id;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            id = ++nextRequest;
+            pending = Request{id, position, limits};
+            stopRunning();
+        }
+        wake.notify_all();
+        return id;
+    }
+
+    // Stop the running search (its final update is still posted) and drop a request that hasn't started yet
+    void cancel()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.reset();
+            stopRunning();
+        }
+    }
+
+    // true while a request is queued or being searched, or there are updates left to poll
+    bool busy()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return running || pending.has_value() || !updates.empty();
+    }
+
+    // Take the oldest update posted by the worker (returns false if there is none, never blocks on the search)
+    bool poll(Update &update)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (updates.empty()) {
+            return false;
+        }
+        update = std::move(updates.front());
+        updates.pop_front();
+        return true;
+    }
+
+private:
+    struct Request
+    {
+        int id;
+
+        Position position;
+
+        SearchLimits limits;
+    };
+
+    TranspositionTable tt;
+
+    ParallelSearch search;
+
+    std::thread worker;
+
+    // guards everything below
+    std::mutex mutex;
+    std::condition_variable wake;
+
+    // next request to search, replaced by newer requests before it starts
+    std::optional<Request> pending;
+
+    std::deque<Update> updates;
+
+    int nextRequest;
+
+    bool running;
+
+    bool quitting;
+
+    // Stop the request being searched (mutex must be held), an idle search is not told to stop so the next request isn't aborted
+    void stopRunning() noexcept
+    {
+        if (running) {
+            search.stop();
+        }
+    }
+
+    void post(int request, bool finished, const SearchInfo &info)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        updates.push_back(Update{request, finished, info});
+    }
+
+    void run()
+    {
+        while (true) {
+            std::optional<Request> request;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                running = false;
+                wake.wait(lock, [this] { return quitting || pending.has_value(); });
+                if (quitting) {
+                    return;
+                }
+                request.swap(pending);
+                running = true;
+                // A stop meant for the previous request may have arrived after it finished
+                search.clearStop();
+            }
+
+            int id = request->id;
+            SearchInfo result = search.run(request->position, request->limits, [this, id](const SearchInfo &info) {
+                post(id, false, info);
+            });
+            post(id, true, result);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <sstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Read only view of a whole file, memory mapped so multi gigabyte files are paged in by the os as they are read
+ * (read into memory instead on platforms without mmap)
+ */
+class MappedFile
+{
+public:
+    // How the file will be read, passed on to the os so it can read ahead (or not) and drop pages already read
+    enum Access
+    {
+        SEQUENTIAL,
+        RANDOM
+    };
+
+    /**
+     * @param path file to map
+     * @param access SEQUENTIAL for a front to back scan, RANDOM for lookups (binary searches, hash probes)
+     * @throws std::runtime_error if the file can't be opened or mapped
+     */
+    explicit MappedFile(const std::string &path, Access access = SEQUENTIAL)
+    {
+#if defined(_WIN32)
+        (void)access;
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot open " + path + "!");
+        }
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        buffer = contents.str();
+        begin = buffer.data();
+        length = buffer.size();
+#else
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) {
+            throw std::runtime_error("Cannot open " + path + "!");
+        }
+        struct stat info;
+        if (::fstat(descriptor, &info) != 0) {
+            ::close(descriptor);
+            throw std::runtime_error("Cannot get the size of " + path + "!");
+        }
+        length = static_cast<std::size_t>(info.st_size);
+        if (length) {
+            void *mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(descriptor);
+                throw std::runtime_error("Cannot map " + path + "!");
+            }
+            ::madvise(mapping, length, access == SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+            begin = static_cast<const char *>(mapping);
+        }
+        // the mapping stays valid after the descriptor is closed
+        ::close(descriptor);
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile()
+    {
+#if !defined(_WIN32)
+        if (begin) {
+            ::munmap(const_cast<char *>(begin), length);
+        }
+#endif
+    }
+
+    std::string_view data() const noexcept
+    {
+        return std::string_view(begin, length);
+    }
+
+    std::size_t size() const noexcept
+    {
+        return length;
+    }
+
+private:
+    const char *begin = nullptr;
+
+    std::size_t length = 0;
+
+#if defined(_WIN32)
+    std::string buffer;
+#endif
+};
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef PARALLEL_SEARCH_H
+#define PARALLEL_SEARCH_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Search.hpp"
+#include "ThreadPool.hpp"
+#include "TranspositionTable.hpp"
+
+/**
+ * Lazy SMP: every thread runs its own iterative deepening search of the root position and they only share the transposition table
+ * Odd helper threads only search the even depths, so every other iteration they are a ply deeper than the main thread and
+ * fill the table ahead of it (even helpers search every depth like the main thread)
+ * The main thread decides when to stop (time / depth limits) and its principal variation is the result
+ */
+class ParallelSearch
+{
+public:
+    // Nodes and completed depth of a single thread
+    struct ThreadStats
+    {
+        uint64 nodes;
+
+        int depth;
+    };
+
+    /**
+     * @param tt transposition table shared by all threads
+     * @param threads number of search threads (0 uses the number of hardware threads)
+     */
+    explicit ParallelSearch(TranspositionTable &tt, int threads = 1) : tt(tt), stopped(false)
+    {
+        setThreads(threads);
+    }
+
+    // Change the number of search threads (must not be called while searching)
+    void setThreads(int threads)
+    {
+        if (threads <= 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        pool.reset();
+        if (threads > 1) {
+            pool = std::make_unique<ThreadPool>(threads - 1);
+        }
+
+        searches.clear();
+        for (int i = 0; i < threads; ++i) {
+            searches.push_back(std::make_unique<Search>(tt, &stopped));
+            searches.back()->setTablebases(tablebases);
+        }
+    }
+
+    int threads() const noexcept
+    {
+        return static_cast<int>(searches.size());
+    }
+
+    // Ask a running search to stop as soon as possible (safe to call from another thread, a stop before run aborts that run)
+    void stop() noexcept
+    {
+        stopped.store(true, std::memory_order_relaxed);
+    }
+
+    // Forget a stop that was meant for an earlier search (call before run, not while searching)
+    void clearStop() noexcept
+    {
+        stopped.store(false, std::memory_order_relaxed);
+    }
+
+    // Probe the tablebases at the root and in every thread's search (nullptr to stop probing, must not be changed while searching)
+    void setTablebases(Tablebases *tablebases) noexcept
+    {
+        this->tablebases = tablebases;
+        for (auto &search : searches) {
+            search->setTablebases(tablebases);
+        }
+    }
+
+    // Forget killer and history tables of every thread
+    void clearHistory() noexcept
+    {
+        for (auto &search : searches) {
+            search->clearHistory();
+        }
+    }
+
+    // Nodes searched by all threads in the current or last search
+    uint64 nodeCount() const noexcept
+    {
+        uint64 total = 0;
+        for (const auto &search : searches) {
+            total += search->nodeCount();
+        }
+        return total;
+    }
+
+    // Per thread statistics of the current or last search (index 0 is the main thread)
+    std::vector<ThreadStats> threadStats() const
+    {
+        std::vector<ThreadStats> stats;
+        for (const auto &search : searches) {
+            stats.push_back({search->nodeCount(), search->depthCount()});
+        }
+        return stats;
+    }
+
+    /**
+     * Search the position on every thread until the limits are reached or stop is called
+     * @param position root position (not modified, every thread searches its own copy)
+     * @param limits limits of the main thread (the node limit only counts the main thread's nodes)
+     * @param callback called with the result of every iteration completed by the main thread (nodes are summed over all threads)
+     * @return result of the main thread with the nodes of all threads
+     */
+    SearchInfo run(const Position &position, const SearchLimits &limits, const Search::Callback &callback = nullptr)
+    {
+        // A root position in the tablebases needs no search
+        if (tablebases) {
+            if (std::optional<Tablebases::RootResult> root = tablebases->probeRoot(position)) {
+                SearchInfo result;
+                result.depth = 1;
+                result.score = Search::tablebaseScore(root->wdl, 0);
+                result.pv.push_back(root->move);
+                if (callback) {
+                    callback(result);
+                }
+                stopped.store(false, std::memory_order_relaxed);
+                return result;
+            }
+        }
+
+        tt.newSearch();
+
+        std::vector<Position> positions(searches.size(), position);
+        for (std::size_t i = 1; i < searches.size(); ++i) {
+            pool->submit([this, i, &positions] {
+                searches[i]->run(positions[i], SearchLimits(), nullptr, i % 2 == 1);
+            });
+        }
+
+        Search::Callback report = nullptr;
+        if (callback) {
+            report = [this, &callback](const SearchInfo &info) {
+                SearchInfo total = info;
+                total.nodes = nodeCount();
+                callback(total);
+            };
+        }
+        SearchInfo result = searches[0]->run(positions[0], limits, report);
+
+        // Helper threads only stop when told to
+        stop();
+        if (pool) {
+            pool->wait();
+        }
+
+        stopped.store(false, std::memory_order_relaxed);
+
+        result.nodes = nodeCount();
+        return result;
+    }
+
+private:
+    TranspositionTable &tt;
+
+    std::atomic<bool> stopped;
+
+    Tablebases *tablebases = nullptr;
+
+    // searches[0] runs on the calling thread, the others on the pool
+    std::vector<std::unique_ptr<Search>> searches;
+
+    std::unique_ptr<ThreadPool> pool;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef PEICE_ATLAS_H
+#define PEICE_ATLAS_H
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// CMake defines CHESSGUI_USE_NANOSVG when nanosvg is found (only one translation unit may include this header then)
+#if defined(CHESSGUI_USE_NANOSVG)
+#define NANOSVG_IMPLEMENTATION
+#define NANOSVGRAST_IMPLEMENTATION
+#include <nanosvg.h>
+#include <nanosvgrast.h>
+#endif
+
+/**
+ * Texture holding every peice image at the size a board draws its squares (column is the peice type, row is the color)
+ * The peices are rasterized from the svg assets when nanosvg is available, else the 120px images are resampled
+ * Atlases are built once per square size and shared by every board of that size
+ */
+class PeiceAtlas
+{
+public:
+    // @return atlas with squareSize x squareSize peice images, built on the first request for that size
+    static std::shared_ptr<const sf::Texture> get(unsigned squareSize)
+    {
+        squareSize = std::max(1u, squareSize);
+
+        static std::mutex mutex;
+        static std::map<unsigned, std::weak_ptr<const sf::Texture>> cache;
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::shared_ptr<const sf::Texture> atlas = cache[squareSize].lock();
+        if (!atlas) {
+            atlas = build(squareSize);
+            cache[squareSize] = atlas;
+        }
+        return atlas;
+    }
+
+private:
+    // 1 letter names used by the svg files and full names used by the png files, in peice type order
+    static constexpr const char *SVG_NAMES = "pnbrqk";
+    static constexpr const char *PNG_DIRECTORY = "assets/120px/";
+
+    static std::shared_ptr<const sf::Texture> build(unsigned squareSize)
+    {
+        static const char *PEICE_NAMES[6] = {"pawn", "knight", "bishop", "rook", "queen", "king"};
+
+        sf::Image atlas;
+        atlas.create(6 * squareSize, 2 * squareSize, sf::Color(0, 0, 0, 0));
+        for (int c = 0; c < 2; ++c) {
+            for (int type = 0; type < 6; ++type) {
+                sf::Image image;
+                if (rasterize(type, c, squareSize, image)) {
+                    atlas.copy(image, type * squareSize, c * squareSize);
+                } else if (image.loadFromFile(std::string(PNG_DIRECTORY) + (c ? "black_" : "white_") + PEICE_NAMES[type] + ".png")) {
+                    atlas.copy(resample(image, squareSize), type * squareSize, c * squareSize);
+                }
+            }
+        }
+
+        auto texture = std::make_shared<sf::Texture>();
+        texture->loadFromImage(atlas);
+        // only matters for the dragged peice, which can sit between pixels
+        texture->setSmooth(true);
+        return texture;
+    }
+
+    // Rasterize assets/Chess_<type><l|d>t45.svg at the given size (returns false without nanosvg or if the file can't be read)
+    static bool rasterize(int type, int c, unsigned squareSize, sf::Image &image)
+    {
+#if defined(CHESSGUI_USE_NANOSVG)
+        std::string path = std::string("assets/Chess_") + SVG_NAMES[type] + (c ? "d" : "l") + "t45.svg";
+        NSVGimage *svg = nsvgParseFromFile(path.c_str(), "px", 96.0f);
+        if (!svg) {
+            return false;
+        }
+        bool rasterized = false;
+        if (svg->width > 0 && svg->height > 0) {
+            NSVGrasterizer *rasterizer = nsvgCreateRasterizer();
+            float scale = std::min(squareSize / svg->width, squareSize / svg->height);
+            std::vector<unsigned char> pixels(4 * squareSize * squareSize);
+            // center images that aren't square
+            float x = (squareSize - svg->width * scale) / 2;
+            float y = (squareSize - svg->height * scale) / 2;
+            nsvgRasterize(rasterizer, svg, x, y, scale, pixels.data(), squareSize, squareSize, 4 * squareSize);
+            nsvgDeleteRasterizer(rasterizer);
+            image.create(squareSize, squareSize, pixels.data());
+            rasterized = true;
+        }
+        nsvgDelete(svg);
+        return rasterized;
+#else
+        (void)type;
+        (void)c;
+        (void)squareSize;
+        (void)image;
+        return false;
+#endif
+    }
+
+    // Box filter the image to size x size, averaging with premultiplied alpha so edges don't darken
+    static sf::Image resample(const sf::Image &source, unsigned size)
+    {
+        sf::Vector2u sourceSize = source.getSize();
+        if (sourceSize.x == size && sourceSize.y == size) {
+            return source;
+        }
+
+        sf::Image result;
+        result.create(size, size, sf::Color(0, 0, 0, 0));
+        for (unsigned y = 0; y < size; ++y) {
+            unsigned top = y * sourceSize.y / size;
+            unsigned bottom = std::max(top + 1, (y + 1) * sourceSize.y / size);
+            for (unsigned x = 0; x < size; ++x) {
+                unsigned left = x * sourceSize.x / size;
+                unsigned right = std::max(left + 1, (x + 1) * sourceSize.x / size);
+
+                unsigned long r = 0, g = 0, b = 0, a = 0, count = 0;
+                for (unsigned sy = top; sy < bottom; ++sy) {
+                    for (unsigned sx = left; sx < right; ++sx) {
+                        sf::Color pixel = source.getPixel(sx, sy);
+                        r += pixel.r * pixel.a;
+                        g += pixel.g * pixel.a;
+                        b += pixel.b * pixel.a;
+                        a += pixel.a;
+                        ++count;
+                    }
+                }
+                if (a) {
+                    result.setPixel(x, y, sf::Color(static_cast<sf::Uint8>(r / a), static_cast<sf::Uint8>(g / a), static_cast<sf::Uint8>(b / a), static_cast<sf::Uint8>(a / count)));
+                }
+            }
+        }
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,248 @@
+#ifndef POLYGLOT_BOOK_H
+#define POLYGLOT_BOOK_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "Position.hpp"
+
+/**
+ * Polyglot position keys
+ * Polyglot books are keyed by their own zobrist scheme, computed from the 781 numbers of the Random64 table.
+ * The table is loaded from a text file instead of being compiled in, so the same code also reads books made with other tables.
+ */
+class PolyglotKeys
+{
+public:
+    static constexpr int TABLE_SIZE = 781;
+
+    // Key of the starting position with the standard Random64 table
+    static constexpr uint64 STANDARD_STARTING_KEY = 0x463B96181691FC9CULL;
+
+    /**
+     * Load the table from a file holding the 781 numbers as 16 digit hex values in order, in any surrounding syntax
+     * (a plain list, or the array copied from polyglot's or another implementation's source)
+     * @throws std::runtime_error if the file can't be read or holds a different number of values
+     */
+    explicit PolyglotKeys(const std::string &path)
+    {
+        std::ifstream file(path);
+        if (!file) {
+            throw std::runtime_error("Cannot open " + path + "!");
+        }
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        std::string text = contents.str();
+
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < text.size();) {
+            // a value is a run of exactly 16 hex digits, optionally after 0x
+            if (text[i] == '0' && i + 1 < text.size() && (text[i + 1] == 'x' || text[i + 1] == 'X')) {
+                i += 2;
+            }
+            std::size_t start = i;
+            while (i < text.size() && std::isxdigit(static_cast<unsigned char>(text[i]))) {
+                ++i;
+            }
+            if (i - start == 16 && (i == text.size() || !std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == 'U' || text[i] == 'u')) {
+                if (count == TABLE_SIZE) {
+                    throw std::runtime_error(path + " should hold exactly " + std::to_string(TABLE_SIZE) + " values!");
+                }
+                table[count++] = std::stoull(text.substr(start, 16), nullptr, 16);
+            }
+            if (i == start) {
+                ++i;
+            }
+        }
+        if (count != TABLE_SIZE) {
+            throw std::runtime_error(path + " should hold exactly " + std::to_string(TABLE_SIZE) + " values!");
+        }
+    }
+
+    // true if the table gives the standard key of the starting position (books made by polyglot can be read)
+    bool isStandard() const
+    {
+        return key(Position()) == STANDARD_STARTING_KEY;
+    }
+
+    // Polyglot key of the position
+    uint64 key(const Position &position) const noexcept
+    {
+        uint64 hash = 0;
+        for (int c = 0; c < 2; ++c) {
+            for (int type = Position::PAWN; type <= Position::KING; ++type) {
+                // polyglot orders the peices black pawn, white pawn, black knight, ...
+                int kind = 2 * (type - Position::PAWN) + (c == 0);
+                uint64 peices = position.peiceBitboard((c << 3) + type);
+                while (peices) {
+                    hash ^= table[64 * kind + popLsb(peices)];
+                }
+            }
+        }
+
+        for (int c = 0; c < 2; ++c) {
+            if (position.castlingRight(c, true)) {
+                hash ^= table[CASTLING_OFFSET + 2 * c];
+            }
+            if (position.castlingRight(c, false)) {
+                hash ^= table[CASTLING_OFFSET + 2 * c + 1];
+            }
+        }
+
+        // only when a pawn of the side to move stands next to the pawn that was pushed
+        int epSquare = position.enPassantSquare();
+        int c = position.sideToMove();
+        if (epSquare >= 0 && (ATTACKS.pawn[!c][epSquare] & position.peiceBitboard((c << 3) + Position::PAWN))) {
+            hash ^= table[EN_PASSANT_OFFSET + epSquare % 8];
+        }
+
+        if (c == 0) {
+            hash ^= table[TURN_OFFSET];
+        }
+        return hash;
+    }
+
+private:
+    static constexpr int CASTLING_OFFSET = 768;
+    static constexpr int EN_PASSANT_OFFSET = 772;
+    static constexpr int TURN_OFFSET = 780;
+
+    uint64 table[TABLE_SIZE];
+};
+
+/**
+ * Memory mapped polyglot opening book (.bin): 16 byte big endian entries sorted by key, binary searched in place
+ */
+class PolyglotBook
+{
+public:
+    // A move of the book for a position
+    struct Entry
+    {
+        Position::Move move;
+
+        // relative frequency of the move
+        int weight;
+    };
+
+    /**
+     * @param bookPath polyglot .bin book
+     * @param keysPath Random64 table (see PolyglotKeys)
+     * @throws std::runtime_error if either file can't be read or the book size is not a multiple of an entry
+     */
+    PolyglotBook(const std::string &bookPath, const std::string &keysPath) : keys(keysPath), file(bookPath, MappedFile::RANDOM)
+    {
+        if (file.size() % ENTRY_SIZE) {
+            throw std::runtime_error(bookPath + " is not a polyglot book!");
+        }
+    }
+
+    const PolyglotKeys &polyglotKeys() const noexcept
+    {
+        return keys;
+    }
+
+    // Legal book moves of the position, most frequent first (book moves that are not legal are skipped)
+    std::vector<Entry> entries(const Position &position) const
+    {
+        uint64 key = keys.key(position);
+        const unsigned char *data = reinterpret_cast<const unsigned char *>(file.data().data());
+        std::size_t count = file.size() / ENTRY_SIZE;
+
+        // first entry with the key
+        std::size_t low = 0;
+        std::size_t high = count;
+        while (low < high) {
+            std::size_t middle = low + (high - low) / 2;
+            if (readBigEndian(data + middle * ENTRY_SIZE, 8) < key) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+
+        std::vector<Entry> found;
+        for (std::size_t i = low; i < count && readBigEndian(data + i * ENTRY_SIZE, 8) == key; ++i) {
+            const unsigned char *entry = data + i * ENTRY_SIZE;
+            std::optional<Position::Move> move = toMove(position, static_cast<int>(readBigEndian(entry + 8, 2)));
+            int weight = static_cast<int>(readBigEndian(entry + 10, 2));
+            if (move.has_value()) {
+                found.push_back(Entry{move.value(), weight});
+            }
+        }
+        std::stable_sort(found.begin(), found.end(), [](const Entry &a, const Entry &b) { return a.weight > b.weight; });
+        return found;
+    }
+
+    /**
+     * Book move for the position
+     * @param random 0 for the most frequent move, else a random number choosing a move in proportion to its weight
+     * @return nullopt if the position is not in the book
+     */
+    std::optional<Position::Move> probe(const Position &position, std::uint32_t random = 0) const
+    {
+        std::vector<Entry> found = entries(position);
+        if (found.empty()) {
+            return std::nullopt;
+        }
+
+        std::uint32_t total = 0;
+        for (const Entry &entry : found) {
+            total += static_cast<std::uint32_t>(entry.weight);
+        }
+        if (random && total) {
+            std::uint32_t pick = random % total;
+            for (const Entry &entry : found) {
+                if (pick < static_cast<std::uint32_t>(entry.weight)) {
+                    return entry.move;
+                }
+                pick -= static_cast<std::uint32_t>(entry.weight);
+            }
+        }
+        return found.front().move;
+    }
+
+private:
+    static constexpr std::size_t ENTRY_SIZE = 16;
+
+    PolyglotKeys keys;
+
+    MappedFile file;
+
+    static uint64 readBigEndian(const unsigned char *bytes, int count) noexcept
+    {
+        uint64 value = 0;
+        for (int i = 0; i < count; ++i) {
+            value = (value << 8) | bytes[i];
+        }
+        return value;
+    }
+
+    // Legal move of a polyglot move: target file [0, 2], target rank [3, 5], start file [6, 8], start rank [9, 11], promotion [12, 14]
+    static std::optional<Position::Move> toMove(const Position &position, int bookMove)
+    {
+        int target = bookMove & 0b111111;
+        int start = (bookMove >> 6) & 0b111111;
+        int promotion = (bookMove >> 12) & 0b111;
+
+        for (const Position::Move &move : position.legalMoves()) {
+            // polyglot writes castling as the king taking its own rook
+            int moveTarget = move.isCastling() ? (move.target() > move.start() ? move.start() + 3 : move.start() - 4) : move.target();
+            if (move.start() == start && moveTarget == target && (move.promotion() ? move.promotion() - Position::PAWN : 0) == promotion) {
+                return move;
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+#endif
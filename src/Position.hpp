@@ -0,0 +1,1828 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <cctype>
+
+#include "precomputed.hpp"
+#include "bitboards.hpp"
+#include "psqt.hpp"
+#include "Stats.hpp"
+
+/**
+ * Rules core of the chess board (peice placement, castling / en passant state, move generation, make / unmake move)
+ * Contains no graphical members so it can be used headless (perft, analysis, etc.)
+ */
+class Position
+{
+public:
+    // DEFINITIONS
+    static constexpr int WHITE = 0b0000;
+    static constexpr int BLACK = 0b1000;
+    static constexpr int PAWN =   0b001;
+    static constexpr int KNIGHT = 0b010;
+    static constexpr int BISHOP = 0b011;
+    static constexpr int ROOK =   0b100;
+    static constexpr int QUEEN =  0b101;
+    static constexpr int KING =   0b110;
+
+    // Longest fen written by writeFEN, including the terminating null char
+    static constexpr std::size_t FEN_CAPACITY = 128;
+
+    // Thrown for a malformed fen (offset is the index of the offending char in the fen)
+    class FenError : public std::invalid_argument
+    {
+    public:
+        FenError(const char *message, std::size_t offset)
+            : std::invalid_argument(std::string(message) + " (at char " + std::to_string(offset) + ")"), errorOffset(offset)
+        {
+        }
+
+        std::size_t offset() const noexcept
+        {
+            return errorOffset;
+        }
+
+    private:
+        std::size_t errorOffset;
+    };
+
+
+    // MOVE
+    // struct for containing info about a move
+    // packed into 32 bits: bits [0, 15] hold the compact 16 bit move (start, target, promotion / special flags)
+    // and bits [16, 23] hold the moving and captured peices so the move can be unmade without extra state
+    class Move
+    {   
+    public:
+        // Starting square of the move [0, 63] -> [a1, h8]
+        inline int start() const noexcept
+        {
+            return data & 0b111111;
+        }
+        
+        // Ending square of the move [0, 63] -> [a1, h8]
+        inline int target() const noexcept
+        {
+            return (data >> TARGET_SHIFT) & 0b111111;
+        }
+
+        // Peice and color of moving peice (peice that is on the starting square of the move
+        inline int moving() const noexcept
+        {
+            return (data >> MOVING_SHIFT) & 0b1111;
+        }
+
+        // Peice and color of captured peice
+        inline int captured() const noexcept
+        {
+            return (data >> CAPTURED_SHIFT) & 0b1111;
+        }
+
+        // Returns the color of the whose move is
+        inline int color() const noexcept
+        {
+            return (moving() >> 3) << 3;
+        }
+
+        // Returs the color who the move is being played against
+        inline int enemy() const noexcept
+        {
+            return !(moving() >> 3) << 3;
+        }
+
+        // In case of promotion, returns the peice value of the promoted peice
+        inline int promotion() const noexcept
+        {
+            return special() == PROMOTION_MOVE ? KNIGHT + ((data >> PROMOTION_SHIFT) & 0b11) : 0;
+        }
+
+        // Returns true if move is en passant move
+        inline bool isEnPassant() const noexcept
+        {
+            return special() == EN_PASSANT_MOVE;
+        }
+
+        // Returns true if move is castling move
+        inline bool isCastling() const noexcept
+        {
+            return special() == CASTLE_MOVE;
+        }
+
+        // Returns true if this is the default constructed (empty) move
+        inline bool isNull() const noexcept
+        {
+            return data == 0;
+        }
+
+        // 16 bit encoding of the move (start, target, promotion and flags) for compact storage
+        // the full move can be restored with Position::moveFromCompact
+        inline uint16 compact() const noexcept
+        {
+            return static_cast<uint16>(data);
+        }
+
+        // Flags that would construct this move (en_passant, castle, promotion, etc.)
+        inline int flags() const noexcept
+        {
+            return compactFlags(compact());
+        }
+
+        // Returns the move in long algebraic notation (ex e2e4, e7e8q)
+        std::string toString() const
+        {
+            std::string str = boardIndexToAlgebraicNotation(start()) + boardIndexToAlgebraicNotation(target());
+            if (promotion()) {
+                str += " pnbrqk"[promotion()];
+            }
+            return str;
+        }
+
+        // Override equality operator with other move
+        inline bool operator==(const Move& other) const
+        {
+            return this->compact() == other.compact();
+        }
+
+        inline bool operator!=(const Move& other) const
+        {
+            return this->compact() != other.compact();
+        }
+
+        // CONSTRUCTORS
+        // Construct a new Move object from the given board and given flags (en_passant, castle, promotion, etc.)
+        Move(const Position *board, int start, int target, int givenFlags=NONE)
+        {
+            int moving = board->peices[start];
+            int captured = (givenFlags & EN_PASSANT) ? (!(moving >> 3) << 3) + PAWN : board->peices[target];
+
+            uint32 special = NORMAL_MOVE;
+            if (givenFlags & PROMOTION) {
+                special = PROMOTION_MOVE | ((givenFlags & PROMOTION) - KNIGHT) << PROMOTION_SHIFT;
+            } else if (givenFlags & EN_PASSANT) {
+                special = EN_PASSANT_MOVE;
+            } else if (givenFlags & CASTLE) {
+                special = CASTLE_MOVE;
+            }
+
+            data = static_cast<uint32>(start)
+                 | static_cast<uint32>(target) << TARGET_SHIFT
+                 | special
+                 | static_cast<uint32>(moving) << MOVING_SHIFT
+                 | static_cast<uint32>(captured) << CAPTURED_SHIFT;
+        }
+
+        Move() : data(0) {}
+
+        // @return the flags (en_passant, castle, promotion, etc.) encoded in a compact 16 bit move
+        static inline int compactFlags(uint16 compact) noexcept
+        {
+            switch (compact & SPECIAL_MASK) {
+                case PROMOTION_MOVE:
+                    return KNIGHT + ((compact >> PROMOTION_SHIFT) & 0b11);
+                case EN_PASSANT_MOVE:
+                    return EN_PASSANT;
+                case CASTLE_MOVE:
+                    return CASTLE;
+                default:
+                    return NONE;
+            }
+        }
+        
+        // FLAGS
+        static constexpr int NONE       = 0b00000;
+        static constexpr int PROMOTION  = 0b00111;
+        static constexpr int EN_PASSANT = 0b01000;
+        static constexpr int CASTLE     = 0b10000;
+    private:
+        // PACKED LAYOUT
+        static constexpr int TARGET_SHIFT = 6;
+        static constexpr int PROMOTION_SHIFT = 12;
+        static constexpr int MOVING_SHIFT = 16;
+        static constexpr int CAPTURED_SHIFT = 20;
+
+        // 2 bit move kind stored in bits [14, 15]
+        static constexpr uint32 SPECIAL_MASK    = 0b11 << 14;
+        static constexpr uint32 NORMAL_MOVE     = 0b00 << 14;
+        static constexpr uint32 PROMOTION_MOVE  = 0b01 << 14;
+        static constexpr uint32 EN_PASSANT_MOVE = 0b10 << 14;
+        static constexpr uint32 CASTLE_MOVE     = 0b11 << 14;
+
+        inline uint32 special() const noexcept
+        {
+            return data & SPECIAL_MASK;
+        }
+
+        // start [0, 5] | target [6, 11] | promotion [12, 13] | kind [14, 15] | moving peice [16, 19] | captured peice [20, 23]
+        uint32 data;
+   };
+
+
+    static_assert(sizeof(Move) == 4, "Move should be packed into 32 bits");
+
+
+    // MOVE LIST
+    // fixed capacity list of moves stored inline (no heap allocation), used by the move generators
+    class MoveList
+    {
+    public:
+        // Upper bound on the number of pseudo legal moves in any reachable position
+        static constexpr int CAPACITY = 256;
+
+        MoveList() : count(0) {}
+
+        inline int size() const noexcept
+        {
+            return count;
+        }
+
+        inline bool empty() const noexcept
+        {
+            return count == 0;
+        }
+
+        inline void clear() noexcept
+        {
+            count = 0;
+        }
+
+        // Construct a move in place at the end of the list
+        template <typename... Args>
+        inline void emplace_back(Args&&... args) noexcept
+        {
+            moves[count++] = Move(std::forward<Args>(args)...);
+        }
+
+        inline void push_back(const Move &move) noexcept
+        {
+            moves[count++] = move;
+        }
+
+        // Shrink the list to the first n moves
+        inline void resize(int n) noexcept
+        {
+            count = n;
+        }
+
+        inline Move &operator[](int i) noexcept
+        {
+            return moves[i];
+        }
+
+        inline const Move &operator[](int i) const noexcept
+        {
+            return moves[i];
+        }
+
+        inline Move *begin() noexcept
+        {
+            return moves;
+        }
+
+        inline Move *end() noexcept
+        {
+            return moves + count;
+        }
+
+        inline const Move *begin() const noexcept
+        {
+            return moves;
+        }
+
+        inline const Move *end() const noexcept
+        {
+            return moves + count;
+        }
+
+    private:
+        Move moves[CAPACITY];
+
+        int count;
+    };
+
+    // CONSTRUCTORS
+    // Construct a new Position object from the starting position
+    Position()
+    {
+        initialize("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    }
+
+    // Construct a new Position object from the given fen string
+    Position(std::string_view fenString)
+    {
+        initialize(fenString);
+    }
+
+    // ACCESSORS
+    // Peice and color at the given square [0, 63] -> [a1, h8] (0 if empty)
+    inline int peiceAt(int square) const noexcept
+    {
+        return peices[square];
+    }
+
+    // Returns 0 if white is to move and 1 if black is to move
+    inline int sideToMove() const noexcept
+    {
+        return totalHalfmoves % 2;
+    }
+
+    // Total half moves since game start
+    inline int halfmoveNumber() const noexcept
+    {
+        return totalHalfmoves;
+    }
+
+    // Zobrist hash of the current position
+    inline uint64 hash() const noexcept
+    {
+        return zobrist;
+    }
+
+    // Restore the full move from its compact 16 bit encoding in the current position
+    Move moveFromCompact(uint16 compact) const
+    {
+        return Move(this, compact & 0b111111, (compact >> 6) & 0b111111, Move::compactFlags(compact));
+    }
+
+    // Bitboard of the squares occupied by the given peice and color
+    inline uint64 peiceBitboard(int peice) const noexcept
+    {
+        return peiceBitboards[peice];
+    }
+
+    // Bitboard of the squares occupied by white or black peices (index 0 and 1)
+    inline uint64 colorBitboard(int c) const noexcept
+    {
+        return colorBitboards[c];
+    }
+
+    // Number of peices of the given peice and color on the board
+    inline int peiceCount(int peice) const noexcept
+    {
+        return peiceCounts[peice];
+    }
+
+    // Index of the white or black king (index 0 and 1)
+    inline int kingSquare(int c) const noexcept
+    {
+        return kingIndex[c];
+    }
+
+    // Number of half moves since the last pawn move or capture
+    inline int halfmoveClock() const noexcept
+    {
+        return states.back().rule50;
+    }
+
+    // Material and piece square score of white minus black, packed middlegame / endgame (see makeScore)
+    inline int psqtScore() const noexcept
+    {
+        return states.back().psqt;
+    }
+
+    // Sum of the PHASE_WEIGHTS of the peices on the board (may exceed MAX_PHASE after promotions)
+    inline int gamePhase() const noexcept
+    {
+        return states.back().phase;
+    }
+
+    // Target square of the last double pawn push, -1 if there is none (an en passant capture may still be impossible)
+    inline int enPassantSquare() const noexcept
+    {
+        return states.back().epSquare;
+    }
+
+    // true if the white or black (index 0 and 1) king keeps the right to castle kingside / queenside
+    inline bool castlingRight(int c, bool kingside) const noexcept
+    {
+        return kingside ? canCastleKingside(c) : canCastleQueenside(c);
+    }
+
+    // Find the legal move written in long algebraic notation (ex e2e4, e7e8q, e1g1 for castling)
+    Move moveFromString(const std::string &str) const
+    {
+        if (str.size() != 4 && str.size() != 5) {
+            throw std::invalid_argument("Move should be in the form [a-h][1-8][a-h][1-8][nbrq]?");
+        }
+        int start = algebraicNotationToBoardIndex(str.substr(0, 2));
+        int target = algebraicNotationToBoardIndex(str.substr(2, 2));
+        int promotion = 0;
+        if (str.size() == 5) {
+            std::size_t type = std::string(" pnbrqk").find(static_cast<char>(std::tolower(str[4])));
+            if (type == std::string::npos || type < KNIGHT || type > QUEEN) {
+                throw std::invalid_argument("Promotion peice should be one of [nbrq]!");
+            }
+            promotion = static_cast<int>(type);
+        }
+
+        for (const Move &move : legalMoves()) {
+            if (move.start() == start && move.target() == target && move.promotion() == promotion) {
+                return move;
+            }
+        }
+        throw std::invalid_argument("Move " + str + " is not legal in the position!");
+    }
+
+    // Find the legal move written in standard algebraic notation (ex e4, Nbd7, exd8=Q, O-O), check and annotation suffixes are ignored
+    Move moveFromSAN(std::string_view san) const
+    {
+        std::string_view written = san;
+        while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?')) {
+            san.remove_suffix(1);
+        }
+
+        // Castling (0-0 is a common mistake for O-O)
+        if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+            bool kingside = san.size() == 3;
+            for (const Move &move : legalMoves()) {
+                if (move.isCastling() && (move.target() > move.start()) == kingside) {
+                    return move;
+                }
+            }
+            throw std::invalid_argument("Move " + std::string(written) + " is not legal in the position!");
+        }
+
+        int type = PAWN;
+        if (!san.empty() && std::isupper(static_cast<unsigned char>(san.front()))) {
+            std::size_t index = std::string_view("PNBRQK").find(san.front());
+            if (index == std::string_view::npos) {
+                throw std::invalid_argument("Unrecognised peice in move " + std::string(written) + "!");
+            }
+            type = static_cast<int>(index) + PAWN;
+            san.remove_prefix(1);
+        }
+
+        // Promotion with or without '=' (ex e8=Q, e8Q)
+        int promotion = 0;
+        if (type == PAWN && !san.empty()) {
+            std::size_t index = std::string_view("NBRQ").find(san.back());
+            if (index != std::string_view::npos) {
+                promotion = static_cast<int>(index) + KNIGHT;
+                san.remove_suffix(1);
+                if (!san.empty() && san.back() == '=') {
+                    san.remove_suffix(1);
+                }
+            }
+        }
+
+        if (san.size() < 2 || san[san.size() - 2] < 'a' || san[san.size() - 2] > 'h' || san.back() < '1' || san.back() > '8') {
+            throw std::invalid_argument("Move " + std::string(written) + " should end with the target square!");
+        }
+        int target = (san.back() - '1') * 8 + (san[san.size() - 2] - 'a');
+        san.remove_suffix(2);
+
+        // Optional capture marker and the file and / or rank of the starting square
+        if (!san.empty() && (san.back() == 'x' || san.back() == ':')) {
+            san.remove_suffix(1);
+        }
+        int file = -1;
+        int rank = -1;
+        for (char ch : san) {
+            if (ch >= 'a' && ch <= 'h') {
+                file = ch - 'a';
+            } else if (ch >= '1' && ch <= '8') {
+                rank = ch - '1';
+            } else {
+                throw std::invalid_argument("Unrecognised char in move " + std::string(written) + "!");
+            }
+        }
+
+        const Move *found = nullptr;
+        for (const Move &move : legalMoves()) {
+            if (move.target() != target || (move.moving() & 0b111) != type || move.promotion() != promotion
+                || (file >= 0 && move.start() % 8 != file) || (rank >= 0 && move.start() / 8 != rank)) {
+                continue;
+            }
+            if (found) {
+                throw std::invalid_argument("Move " + std::string(written) + " is ambiguous in the position!");
+            }
+            found = &move;
+        }
+        if (!found) {
+            throw std::invalid_argument("Move " + std::string(written) + " is not legal in the position!");
+        }
+        return *found;
+    }
+
+    // Write the legal move in standard algebraic notation with a check or mate suffix (the move is made and unmade to find it)
+    std::string moveToSAN(const Move &move)
+    {
+        std::string san;
+        int type = move.moving() & 0b111;
+        if (move.isCastling()) {
+            san = move.target() > move.start() ? "O-O" : "O-O-O";
+        } else {
+            if (type != PAWN) {
+                san += "PNBRQK"[type - PAWN];
+
+                // Start file, rank or both when another peice of the same type can reach the target
+                bool ambiguous = false;
+                bool sameFile = false;
+                bool sameRank = false;
+                for (const Move &other : legalMoves()) {
+                    if (other.target() == move.target() && other.moving() == move.moving() && other.start() != move.start()) {
+                        ambiguous = true;
+                        sameFile |= other.start() % 8 == move.start() % 8;
+                        sameRank |= other.start() / 8 == move.start() / 8;
+                    }
+                }
+                if (ambiguous && (!sameFile || sameRank)) {
+                    san += static_cast<char>('a' + move.start() % 8);
+                }
+                if (ambiguous && sameFile) {
+                    san += static_cast<char>('1' + move.start() / 8);
+                }
+            }
+            if (move.captured()) {
+                if (type == PAWN) {
+                    san += static_cast<char>('a' + move.start() % 8);
+                }
+                san += 'x';
+            }
+            san += static_cast<char>('a' + move.target() % 8);
+            san += static_cast<char>('1' + move.target() / 8);
+            if (move.promotion()) {
+                san += '=';
+                san += "PNBRQK"[move.promotion() - PAWN];
+            }
+        }
+
+        makeMove(move);
+        if (inCheck()) {
+            san += legalMoves().empty() ? '#' : '+';
+        }
+        unmakeMove(move);
+        return san;
+    }
+
+    // Returns the last move played (if any)
+    std::optional<Move> lastMove() const
+    {
+        if (states.size() < 2) {
+            return std::nullopt;
+        }
+        return states.back().move;
+    }
+
+    // BOARD METHODS
+    /**
+     * Initialize engine members for the position in Forsyth–Edwards Notation (no allocations)
+     * The halfmove clock and fullmove number are optional, nothing may follow them
+     * @throws FenError with the index of the offending char, std::invalid_argument without exactly one king of each color
+     * (the position is left unchanged)
+     */
+    void initialize(std::string_view fen)
+    {
+        std::size_t i = 0;
+
+        // next space separated field of the fen (empty at the end of the fen)
+        auto nextField = [&fen, &i]() {
+            while (i < fen.size() && fen[i] == ' ') {
+                ++i;
+            }
+            std::size_t start = i;
+            while (i < fen.size() && fen[i] != ' ') {
+                ++i;
+            }
+            return fen.substr(start, i - start);
+        };
+        auto offset = [&fen](std::string_view field) {
+            return static_cast<std::size_t>(field.data() - fen.data());
+        };
+
+        // Peice placement data (rank 8 first, files a to h)
+        int board[64] = {};
+        std::string_view placement = nextField();
+        if (placement.empty()) {
+            throw FenError("Cannot get peice placement from FEN!", i);
+        }
+        int rank = 7;
+        int file = 0;
+        for (std::size_t j = 0; j < placement.size(); ++j) {
+            char ch = placement[j];
+            if (ch == '/') {
+                if (file != 8) {
+                    throw FenError("Rank in FEN peice placement data should have 8 squares!", offset(placement) + j);
+                }
+                if (rank == 0) {
+                    throw FenError("FEN peice placement data has more than 8 ranks!", offset(placement) + j);
+                }
+                --rank;
+                file = 0;
+            } else if (ch >= '1' && ch <= '8') {
+                file += ch - '0';
+                if (file > 8) {
+                    throw FenError("Rank in FEN peice placement data should have 8 squares!", offset(placement) + j);
+                }
+            } else {
+                std::size_t type = std::string_view("PNBRQKpnbrqk").find(ch);
+                if (type == std::string_view::npos) {
+                    // Only "12345678pnbrqkPNBRQK/" are allowed in peice placement data
+                    throw FenError("Unrecognised char in FEN peice placement data!", offset(placement) + j);
+                }
+                if (file == 8) {
+                    throw FenError("Rank in FEN peice placement data should have 8 squares!", offset(placement) + j);
+                }
+                board[rank * 8 + file++] = ((type >= 6) << 3) + static_cast<int>(type % 6) + PAWN;
+            }
+        }
+        if (rank != 0 || file != 8) {
+            throw FenError("FEN peice placement data should have 8 ranks of 8 squares!", offset(placement) + placement.size());
+        }
+
+        // Active color
+        std::string_view activeColor = nextField();
+        if (activeColor.empty()) {
+            throw FenError("Cannot get active color from FEN!", i);
+        }
+        if (activeColor != "w" && activeColor != "b") {
+            throw FenError("Unrecognised charecter in FEN active color", offset(activeColor));
+        }
+        int side = activeColor == "b";
+
+        // Castling availability
+        std::string_view castlingAvailability = nextField();
+        if (castlingAvailability.empty()) {
+            throw FenError("Cannot get castling availability from FEN!", i);
+        }
+        int castlingRights = 0;
+        if (castlingAvailability != "-") {
+            for (std::size_t j = 0; j < castlingAvailability.size(); ++j) {
+                char castlingInfo = castlingAvailability[j];
+                int c = castlingInfo >= 'a' && castlingInfo <= 'z';
+                switch (castlingInfo) {
+                    case 'K':
+                    case 'k':
+                        castlingRights |= KINGSIDE_CASTLING << (2 * c);
+                        break;
+                    case 'Q':
+                    case 'q':
+                        castlingRights |= QUEENSIDE_CASTLING << (2 * c);
+                        break;
+                    default:
+                        throw FenError("Unrecognised char in FEN castling availability data!", offset(castlingAvailability) + j);
+                }
+            }
+        }
+
+        // En passant target (on the third or sixth rank)
+        std::string_view enPassantTarget = nextField();
+        if (enPassantTarget.empty()) {
+            throw FenError("Cannot get en passant target from FEN!", i);
+        }
+        int epSquare = -1;
+        if (enPassantTarget != "-") {
+            if (enPassantTarget.size() != 2 || enPassantTarget[0] < 'a' || enPassantTarget[0] > 'h' || (enPassantTarget[1] != '3' && enPassantTarget[1] != '6')) {
+                throw FenError("Invalid FEN en passant target!", offset(enPassantTarget));
+            }
+            epSquare = (enPassantTarget[1] - '1') * 8 + (enPassantTarget[0] - 'a');
+        }
+
+        // Half move clock and full move number (0 and 1 if missing)
+        auto number = [&offset](std::string_view field, int missing, const char *error) {
+            if (field.empty()) {
+                return missing;
+            }
+            int value = 0;
+            auto [end, result] = std::from_chars(field.data(), field.data() + field.size(), value);
+            if (result != std::errc() || end != field.data() + field.size() || value < 0) {
+                throw FenError(error, offset(field));
+            }
+            return value;
+        };
+        int rule50 = std::min(number(nextField(), 0, "Invalid FEN half move clock!"), static_cast<int>(INT16_MAX));
+        int fullmoveNumber = std::max(1, number(nextField(), 1, "Invalid FEN full move number!"));
+        std::string_view extra = nextField();
+        if (!extra.empty()) {
+            throw FenError("Unexpected text after the FEN full move number!", offset(extra));
+        }
+
+        // The fen is valid, replace the current position
+        setup(board, side, castlingRights, epSquare, rule50, fullmoveNumber);
+    }
+
+    // FIXED SIZE ENCODING
+    // 32 byte encoding of a position (fields are in host byte order, little endian on every supported platform)
+    struct Packed
+    {
+        // squares with a peice
+        uint64 occupied;
+
+        // 4 bit peice and color of every occupied square from a1 to h8 (low nibble first)
+        std::uint8_t peices[16];
+
+        // side to move in bit 0, castling rights in bits [1, 4]
+        std::uint8_t flags;
+
+        // en passant target square, -1 if none
+        std::int8_t epSquare;
+
+        std::uint16_t rule50;
+
+        std::uint16_t fullmoveNumber;
+
+        // always 0
+        std::uint8_t reserved[2];
+    };
+
+    static_assert(sizeof(Packed) == 32, "Packed position should be exactly 32 bytes");
+
+    // Encode the position (round trips through initialize(const Packed &) except for the game history)
+    Packed pack() const noexcept
+    {
+        Packed packed = {};
+        packed.occupied = colorBitboards[0] | colorBitboards[1];
+        uint64 occupied = packed.occupied;
+        for (int i = 0; occupied; ++i) {
+            packed.peices[i / 2] |= static_cast<std::uint8_t>(peices[popLsb(occupied)] << (4 * (i % 2)));
+        }
+        packed.flags = static_cast<std::uint8_t>((totalHalfmoves % 2) | (states.back().castlingRights << 1));
+        packed.epSquare = states.back().epSquare;
+        packed.rule50 = static_cast<std::uint16_t>(states.back().rule50);
+        packed.fullmoveNumber = static_cast<std::uint16_t>(1 + totalHalfmoves / 2);
+        return packed;
+    }
+
+    // Initialize engine members for an encoded position (throws std::invalid_argument for a corrupt encoding, the position is left unchanged)
+    void initialize(const Packed &packed)
+    {
+        if (popcount(packed.occupied) > 32) {
+            throw std::invalid_argument("Packed position has more than 32 peices!");
+        }
+        int board[64] = {};
+        uint64 occupied = packed.occupied;
+        for (int i = 0; occupied; ++i) {
+            int peice = (packed.peices[i / 2] >> (4 * (i % 2))) & 0b1111;
+            if ((peice & 0b111) < PAWN || (peice & 0b111) > KING) {
+                throw std::invalid_argument("Unrecognised peice in packed position!");
+            }
+            board[popLsb(occupied)] = peice;
+        }
+        if (packed.flags >> 5) {
+            throw std::invalid_argument("Unrecognised flags in packed position!");
+        }
+        if (packed.epSquare != -1 && (packed.epSquare < 0 || (packed.epSquare / 8 != 2 && packed.epSquare / 8 != 5))) {
+            throw std::invalid_argument("Invalid en passant target in packed position!");
+        }
+        setup(board, packed.flags & 1, packed.flags >> 1, packed.epSquare, std::min<int>(packed.rule50, INT16_MAX), std::max<int>(1, packed.fullmoveNumber));
+    }
+
+
+    // Kinds of moves a generator produces (CAPTURES and QUIETS split the legal moves of a position not in check)
+    // CAPTURES: captures (with every promotion), en passant and pushes promoting to a queen
+    // QUIETS: the other legal moves (under promoting pushes and castling included)
+    // EVASIONS: every legal move of a position in check
+    // LEGAL: every legal move
+    enum GenType
+    {
+        CAPTURES,
+        QUIETS,
+        EVASIONS,
+        LEGAL
+    };
+
+    // Generates pseudo legal moves for the current position into the given move list (list is cleared first)
+    void pseudoLegalMoves(MoveList &moves) const
+    {
+        if (totalHalfmoves % 2) {
+            pseudoLegalMoves<1>(moves);
+        } else {
+            pseudoLegalMoves<0>(moves);
+        }
+    }
+
+    // Generates legal moves of the given type for the current position into the given move list (list is cleared first)
+    template <GenType Type>
+    void generateMoves(MoveList &moves) const
+    {
+        if (totalHalfmoves % 2) {
+            generateMoves<1, Type>(moves);
+        } else {
+            generateMoves<0, Type>(moves);
+        }
+    }
+
+    // Generates legal moves for the current position into the given move list (list is cleared first)
+    void legalMoves(MoveList &moves) const
+    {
+        generateMoves<LEGAL>(moves);
+    }
+
+    // Legal moves for the current position, generated on the first call in a ply and kept until the move is unmade
+    // (the reference stays valid across makeMove / unmakeMove, the contents are only valid while the position is current)
+    const MoveList &legalMoves() const
+    {
+        DerivedState &state = derivedStates[states.size() - 1];
+        if (!(state.known & MOVES_KNOWN)) {
+            legalMoves(state.moves);
+            state.known |= MOVES_KNOWN;
+        }
+        return state.moves;
+    }
+    
+    // update the board based on the inputted move (must be legal)
+    void makeMove(const Move &move)
+    {
+        Stats::add(Stats::MAKE_MOVES);
+        int c = move.moving() >> 3;
+        int color = c << 3;
+        int e = !color;
+        
+        // UPDATE PEICE DATA / ZOBRIST HASH
+        // Update zobrist hash for turn change and expired en passant target
+        zobrist ^= ZOBRIST_TURN_KEY;
+        zobrist ^= enPassantKey();
+
+        // New state record starts as a copy of the previous one
+        states.push_back(states.back());
+        StateInfo &state = states.back();
+        state.move = move;
+
+        // Derived state of the new ply is computed when first needed (the previous ply keeps its state for unmakeMove)
+        if (states.size() > derivedStates.size()) {
+            derivedStates.emplace_back();
+        }
+        derivedStates[states.size() - 1].known = 0;
+
+        // Update zobrist hash and peice data for capture
+        if (move.isEnPassant()) {
+            int captureSquare = move.target() - 8 + 16 * c;
+            removePeice(captureSquare);
+            zobrist ^= ZOBRIST_PEICE_KEYS[e][move.captured() % (1 << 3) - 1][captureSquare];
+            state.psqt -= PSQT.score[move.captured()][captureSquare];
+
+        } else if (move.captured()) {
+            removePeice(move.target());
+            zobrist ^= ZOBRIST_PEICE_KEYS[e][move.captured() % (1 << 3) - 1][move.target()];
+            state.psqt -= PSQT.score[move.captured()][move.target()];
+            state.phase -= PSQT.phase[move.captured()];
+        }
+
+        // Update peice data and zobrist hash for moving peice
+        removePeice(move.start());
+        zobrist ^= ZOBRIST_PEICE_KEYS[c][move.moving() % (1 << 3) - 1][move.start()];
+        state.psqt -= PSQT.score[move.moving()][move.start()];
+
+        if (move.promotion()) {
+            placePeice(move.target(), color + move.promotion());
+            zobrist ^= ZOBRIST_PEICE_KEYS[c][move.promotion() - 1][move.target()];
+            state.psqt += PSQT.score[color + move.promotion()][move.target()];
+            state.phase += PSQT.phase[color + move.promotion()];
+            
+        } else {
+            placePeice(move.target(), move.moving());
+            zobrist ^= ZOBRIST_PEICE_KEYS[c][move.moving() % (1 << 3) - 1][move.target()];
+            state.psqt += PSQT.score[move.moving()][move.target()];
+        }
+
+        // Update rooks for castling
+        if (move.isCastling()) {
+            int rookStart;
+            int rookEnd;
+
+            int castlingRank = move.target() & 0b11111000;
+            if (move.target() % 8 < 4) {
+                // Queenside castling
+                rookStart = castlingRank;
+                rookEnd = castlingRank + 3;
+            } else {
+                // Kingside castling
+                rookStart = castlingRank + 7;
+                rookEnd = castlingRank + 5;
+            }
+
+            removePeice(rookStart);
+            placePeice(rookEnd, color + ROOK);
+
+            zobrist ^= ZOBRIST_PEICE_KEYS[c][ROOK - 1][rookStart];
+            zobrist ^= ZOBRIST_PEICE_KEYS[c][ROOK - 1][rookEnd];
+            state.psqt += PSQT.score[color + ROOK][rookEnd] - PSQT.score[color + ROOK][rookStart];
+        }
+
+        // UPDATE BOARD FLAGS
+        // Update king index
+        if (move.moving() % (1 << 3) == KING) {
+            kingIndex[c] = move.target();
+        }
+
+        // increment counters
+        ++totalHalfmoves;
+        if (move.captured() || move.moving() == color + PAWN) {
+            state.rule50 = 0;
+        } else {
+            ++state.rule50;
+        }
+
+        // En passant file
+        if (move.moving() % (1 << 3) == PAWN && std::abs(move.target() - move.start()) == 16) {
+            state.epSquare = static_cast<std::int8_t>((move.start() + move.target()) / 2);
+        } else {
+            state.epSquare = -1;
+        }
+        zobrist ^= enPassantKey();
+
+        // update castling rights (moving from or to a king or rook square loses the rights of that peice)
+        int rights = state.castlingRights & castlingRightsKept(move.start()) & castlingRightsKept(move.target());
+        int lost = state.castlingRights ^ rights;
+        if (lost) {
+            for (int side = 0; side < 2; ++side) {
+                if (lost & (KINGSIDE_CASTLING << (2 * side))) {
+                    zobrist ^= ZOBRIST_KINGSIDE_CASTLING_KEYS[side];
+                }
+                if (lost & (QUEENSIDE_CASTLING << (2 * side))) {
+                    zobrist ^= ZOBRIST_QUEENSIDE_CASTLING_KEYS[side];
+                }
+            }
+            state.castlingRights = static_cast<std::int8_t>(rights);
+        }
+
+        state.hash = zobrist;
+        ++repetitionFilter[zobrist & REPETITION_FILTER_MASK];
+    }
+
+    // update the board to reverse the inputted move (must have just been move previously played)
+    void unmakeMove(const Move &move)
+    {
+        Stats::add(Stats::UNMAKE_MOVES);
+#ifndef NDEBUG
+        // Checked before anything is changed so the position is still valid if the exception is caught (release builds skip it)
+        if (states.size() < 2 || states.back().move != move) {
+            throw std::runtime_error("Move to unmake is not the last move played in unmakeMove!");
+        }
+#endif
+        int c = move.moving() >> 3;
+        int color = c << 3;
+
+        // UNDO PEICE DATA
+        // Undo peice data for moving peice
+        removePeice(move.target());
+        placePeice(move.start(), move.moving());
+        
+        if (move.isEnPassant()) {
+            placePeice(move.target() - 8 + 16 * c, move.captured());
+        } else if (move.captured()) {
+            placePeice(move.target(), move.captured());
+        }
+
+        // Undo rooks for castling
+        if (move.isCastling()) {
+            int rookStart;
+            int rookEnd;
+
+            int castlingRank = move.target() & 0b11111000;
+            if (move.target() % 8 < 4) {
+                // Queenside castling
+                rookStart = castlingRank;
+                rookEnd = castlingRank + 3;
+            } else {
+                // Kingside castling
+                rookStart = castlingRank + 7;
+                rookEnd = castlingRank + 5;
+            }
+
+            removePeice(rookEnd);
+            placePeice(rookStart, color + ROOK);
+        }
+
+        // UBDO BOARD FLAGS
+        // Undo king index
+        if (move.moving() % (1 << 3) == KING) {
+            kingIndex[c] = move.start();
+        }
+
+        --totalHalfmoves;
+
+        // Restore the previous state record (en passant square, halfmove clock, castling rights and zobrist hash)
+        // its derived state is still cached
+        --repetitionFilter[states.back().hash & REPETITION_FILTER_MASK];
+        states.pop_back();
+        zobrist = states.back().hash;
+    }
+
+    // Result of a finished game: 1 if white won, -1 if black won, 0 for a draw (nullopt while the game goes on)
+    std::optional<int> gameOver() const
+    {
+        if (isDraw()) {
+            return 0;
+        }
+        if (legalMoves().empty()) {
+            return inCheck() ? 2 * sideToMove() - 1 : 0;
+        }
+        return std::nullopt;
+    }
+
+    // returns true if the last move has put the game into a forced draw (threefold repitition / 50 move rule / insufficient material)
+    bool isDraw() const
+    {
+        DerivedState &state = derivedStates[states.size() - 1];
+        if (!(state.known & DRAW_KNOWN)) {
+            state.draw = isDrawByFiftyMoveRule() || isDrawByInsufficientMaterial() || isDrawByThreefoldRepitition();
+            state.known |= DRAW_KNOWN;
+        }
+        return state.draw;
+    }
+
+    // returns true if the last move played has led to a draw by threefold repitition
+    bool isDrawByThreefoldRepitition() const noexcept
+    {
+        // At least two earlier positions must share the filter entry of the current one
+        if (states.back().rule50 < 8 || repetitionFilter[zobrist & REPETITION_FILTER_MASK] < 3) {
+            return false;
+        }
+
+        bool repititionFound = false;
+
+        int end = std::max(0, static_cast<int>(states.size()) - 1 - states.back().rule50);
+        for (int i = static_cast<int>(states.size()) - 5; i >= end; i -= 2) {
+            if (states[i].hash == zobrist) {
+                if (repititionFound) {
+                    return true;
+                }
+                repititionFound = true;
+            }
+        }
+        return false;
+    }
+    
+    // returns true if the current position has occured before since the last pawn move or capture (used by search to score repititions as draws)
+    bool isRepetition() const noexcept
+    {
+        if (repetitionFilter[zobrist & REPETITION_FILTER_MASK] < 2) {
+            return false;
+        }
+
+        int end = std::max(0, static_cast<int>(states.size()) - 1 - states.back().rule50);
+        for (int i = static_cast<int>(states.size()) - 3; i >= end; i -= 2) {
+            if (states[i].hash == zobrist) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // returns true if the last move played has led to a draw by the fifty move rule (100 half moves without a pawn move or capture)
+    bool isDrawByFiftyMoveRule() const noexcept
+    {
+        return states.back().rule50 >= 100;
+    }
+    
+    // returns true if there isnt enough material on the board to deliver checkmate
+    bool isDrawByInsufficientMaterial() const noexcept
+    {
+        if (colorCounts[0] > 3 || colorCounts[1] > 3) {
+            return false;
+        }
+        
+        if (colorCounts[0] == 3 || colorCounts[1] == 3) {
+            return (peiceCounts[WHITE + KNIGHT] == 2 || peiceCounts[BLACK + KNIGHT] == 2) && (colorCounts[0] == 1 || colorCounts[1] == 1);
+        }
+        return !(peiceCounts[WHITE + PAWN] || peiceCounts[BLACK + PAWN] || peiceCounts[WHITE + ROOK] || peiceCounts[BLACK + ROOK] || peiceCounts[WHITE + QUEEN] || peiceCounts[BLACK + QUEEN]);
+    }
+ 
+    // return true if the player who is to move is currently in check
+    bool inCheck() const
+    {
+        return checkers();
+    }
+
+    // return a bitboard of the enemy peices giving check to the player to move (computed once per ply)
+    uint64 checkers() const
+    {
+        DerivedState &state = derivedStates[states.size() - 1];
+        if (!(state.known & CHECKERS_KNOWN)) {
+            int c = totalHalfmoves % 2;
+            state.checkers = attackers(kingIndex[c], colorBitboards[0] | colorBitboards[1]) & colorBitboards[!c];
+            state.known |= CHECKERS_KNOWN;
+        }
+        return state.checkers;
+    }
+    
+    // return true if the king belonging to the inputted color is currently being attacked
+    bool inCheck(int c) const
+    {
+        return attackers(kingIndex[c], colorBitboards[0] | colorBitboards[1]) & colorBitboards[!c];
+    }
+
+    // return a bitboard of the peices of the inputted color that are pinned to their king
+    uint64 pinnedPeices(int c) const noexcept
+    {
+        int king = kingIndex[c];
+        int enemy = !c << 3;
+        uint64 occupied = colorBitboards[0] | colorBitboards[1];
+
+        // Enemy sliders that would attack the king on an empty board
+        uint64 snipers = (ATTACKS.rook(king, 0) & (peiceBitboards[enemy + ROOK] | peiceBitboards[enemy + QUEEN]))
+                       | (ATTACKS.bishop(king, 0) & (peiceBitboards[enemy + BISHOP] | peiceBitboards[enemy + QUEEN]));
+
+        uint64 pinned = 0;
+        while (snipers) {
+            uint64 blockers = ATTACKS.between[king][popLsb(snipers)] & occupied;
+            if (blockers && !(blockers & (blockers - 1))) {
+                pinned |= blockers & colorBitboards[c];
+            }
+        }
+        return pinned;
+    }
+
+    // return a bitboard of all peices (of both colors) attacking the given square with the given occupied squares
+    uint64 attackers(int square, uint64 occupied) const noexcept
+    {
+        uint64 rooksAndQueens = peiceBitboards[WHITE + ROOK] | peiceBitboards[BLACK + ROOK] | peiceBitboards[WHITE + QUEEN] | peiceBitboards[BLACK + QUEEN];
+        uint64 bishopsAndQueens = peiceBitboards[WHITE + BISHOP] | peiceBitboards[BLACK + BISHOP] | peiceBitboards[WHITE + QUEEN] | peiceBitboards[BLACK + QUEEN];
+
+        return (ATTACKS.pawn[1][square] & peiceBitboards[WHITE + PAWN])
+             | (ATTACKS.pawn[0][square] & peiceBitboards[BLACK + PAWN])
+             | (ATTACKS.knight[square] & (peiceBitboards[WHITE + KNIGHT] | peiceBitboards[BLACK + KNIGHT]))
+             | (ATTACKS.king[square] & (peiceBitboards[WHITE + KING] | peiceBitboards[BLACK + KING]))
+             | (ATTACKS.rook(square, occupied) & rooksAndQueens)
+             | (ATTACKS.bishop(square, occupied) & bishopsAndQueens);
+    }
+
+    /**
+     * Write the position in Forsyth–Edwards Notation into the buffer (no allocations)
+     * @param buffer at least FEN_CAPACITY chars, the fen is null terminated
+     * @return pointer to the terminating null char (the length of the fen is the returned pointer - buffer)
+     */
+    char *writeFEN(char *buffer) const noexcept
+    {
+        char *out = buffer;
+
+        // Peice placement data
+        static constexpr char PEICE_CHARS[2][6] = {{'P', 'N', 'B', 'R', 'Q', 'K'}, {'p', 'n', 'b', 'r', 'q', 'k'}};
+        for (int i = 56; i >= 0; i -= 8) {
+            int gap = 0;
+            for (int j = 0; j < 8; ++j) {
+                int peice = peices[i + j];
+                if (!peice) {
+                    ++gap;
+                    continue;
+                }
+                // Add gap charecter if needed
+                if (gap) {
+                    *out++ = static_cast<char>('0' + gap);
+                    gap = 0;
+                }
+                *out++ = PEICE_CHARS[peice >> 3][(peice % (1 << 3)) - 1];
+            }
+            if (gap) {
+                *out++ = static_cast<char>('0' + gap);
+            }
+            // Add rank seperator
+            if (i != 0) {
+                *out++ = '/';
+            }
+        }
+
+        // Player to move
+        *out++ = ' ';
+        *out++ = totalHalfmoves % 2 ? 'b' : 'w';
+        *out++ = ' ';
+
+        // Castling availiability
+        char *castling = out;
+        if (canCastleKingside(0)) {
+            *out++ = 'K';
+        }
+        if (canCastleQueenside(0)) {
+            *out++ = 'Q';
+        }
+        if (canCastleKingside(1)) {
+            *out++ = 'k';
+        }
+        if (canCastleQueenside(1)) {
+            *out++ = 'q';
+        }
+        if (out == castling) {
+            *out++ = '-';
+        }
+        *out++ = ' ';
+
+        // En passant target
+        int epSquare = states.back().epSquare;
+        if (epSquare >= 0) {
+            *out++ = static_cast<char>('a' + epSquare % 8);
+            *out++ = static_cast<char>('1' + epSquare / 8);
+        } else {
+            *out++ = '-';
+        }
+        *out++ = ' ';
+
+        // Halfmoves since pawn move or capture and total moves (the numbers fit easily in the remaining capacity)
+        out = std::to_chars(out, buffer + FEN_CAPACITY - 1, states.back().rule50).ptr;
+        *out++ = ' ';
+        out = std::to_chars(out, buffer + FEN_CAPACITY - 1, 1 + totalHalfmoves / 2).ptr;
+
+        *out = '\0';
+        return out;
+    }
+
+    // return a string representation of the position in Forsyth–Edwards Notation
+    std::string asFEN() const
+    {
+        char buffer[FEN_CAPACITY];
+        return std::string(buffer, writeFEN(buffer));
+    }
+
+    // return true if inputted pseudo legal move is legal in the current position
+    bool isLegal(const Move &move) const
+    {
+        int c = move.moving() >> 3;
+        int e = !c;
+
+        // Seperately check legality of castling moves
+        if (move.isCastling()) {
+            return castlingMoveIsLegal(move);
+        }
+        
+        // Occupied squares and enemy peices after the move is played
+        uint64 captured = move.captured() ? squareBitboard(move.isEnPassant() ? move.target() - 8 + 16 * c : move.target()) : 0;
+        uint64 occupied = ((colorBitboards[0] | colorBitboards[1]) ^ squareBitboard(move.start()) ^ captured) | squareBitboard(move.target());
+        uint64 enemies = colorBitboards[e] & ~captured;
+
+        int king = move.moving() % (1 << 3) == KING ? move.target() : kingIndex[c];
+
+        // Check if move was illegal
+        return !(attackers(king, occupied) & enemies);
+    }
+
+    // @param move pseudo legal castling move (castling rights are not lost and king is not in check)
+    // @return true if the castling move is legal in the current position
+    bool castlingMoveIsLegal(const Move &move) const
+    {
+        if (inCheck()) {
+            return false;
+        }
+
+        int c = move.moving() >> 3;
+        int e = !c;
+        int castlingRank = move.start() & 0b11111000;
+        uint64 occupied = colorBitboards[0] | colorBitboards[1];
+
+        // Check if anything is attacking squares on king's path
+        int s;
+        int end;
+        if (move.target() - castlingRank < 4) {
+            s = castlingRank + 2;
+            end = castlingRank + 3;
+        } else {
+            s = castlingRank + 5;
+            end = castlingRank + 6;
+        }
+        for (; s <= end; ++s) {
+            if (attackers(s, occupied) & colorBitboards[e]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @param algebraic notation for position on chess board (ex e3, a1, c8)
+     * @return uint8 index [0, 63] -> [a1, h8] of square on board
+     */
+    static int algebraicNotationToBoardIndex(const std::string &algebraic)
+    {
+        if (algebraic.size() != 2) {
+            throw std::invalid_argument("Algebraic notation should only be two letters long!");
+        }
+
+        int file = algebraic[0] - 'a';
+        int rank = algebraic[1] - '1';
+
+        if (file < 0 || file > 7 || rank < 0 || rank > 7) {
+            throw std::invalid_argument("Algebraic notation should be in the form [a-h][1-8]!");
+        }
+
+        return rank * 8 + file;
+    }
+
+    /**
+     * @param boardIndex index [0, 63] -> [a1, h8] of square on board
+     * @return std::string notation for position on chess board (ex e3, a1, c8)
+     */
+    static std::string boardIndexToAlgebraicNotation(int boardIndex)
+    {
+        if (boardIndex < 0 || boardIndex > 63) {
+            throw std::invalid_argument("Algebraic notation should only be two letters long!");
+        }
+        
+        char file = 'a' + boardIndex % 8;
+        char rank = '1' + boardIndex / 8;
+
+        std::string algebraic;
+        algebraic = file;
+        algebraic += rank;
+        
+        return algebraic;
+    }
+
+private:
+    /**
+     * Replace the position with the given peices and state (castling rights without the king and rook on their squares are dropped)
+     * @param board peice and color of every square from a1 to h8 (0 if empty)
+     * @param side 0 if white is to move, 1 if black is to move
+     * @throws std::invalid_argument without exactly one king of each color (checked before anything is changed)
+     */
+    void setup(const int board[64], int side, int castlingRights, int epSquare, int rule50, int fullmoveNumber)
+    {
+        // Check detection and move generation need exactly one king of each color
+        if (std::count(board, board + 64, WHITE + KING) != 1) {
+            throw std::invalid_argument("Position should have exactly one white king!");
+        }
+        if (std::count(board, board + 64, BLACK + KING) != 1) {
+            throw std::invalid_argument("Position should have exactly one black king!");
+        }
+        std::copy(board, board + 64, std::begin(peices));
+        kingIndex[0] = 0;
+        kingIndex[1] = 0;
+        for (int i = 0; i < 64; ++i) {
+            if (board[i] % (1 << 3) == KING) {
+                kingIndex[board[i] >> 3] = i;
+            }
+        }
+        totalHalfmoves = side + 2 * (fullmoveNumber - 1);
+
+        for (int c = 0; c < 2; ++c) {
+            int color = c << 3;
+            int castlingRank = 56 * c;
+            if (board[castlingRank + 4] != color + KING || board[castlingRank + 7] != color + ROOK) {
+                castlingRights &= ~(KINGSIDE_CASTLING << (2 * c));
+            }
+            if (board[castlingRank + 4] != color + KING || board[castlingRank] != color + ROOK) {
+                castlingRights &= ~(QUEENSIDE_CASTLING << (2 * c));
+            }
+        }
+
+        zobrist = side ? ZOBRIST_TURN_KEY : 0;
+        for (int c = 0; c < 2; ++c) {
+            if (castlingRights & (KINGSIDE_CASTLING << (2 * c))) {
+                zobrist ^= ZOBRIST_KINGSIDE_CASTLING_KEYS[c];
+            }
+            if (castlingRights & (QUEENSIDE_CASTLING << (2 * c))) {
+                zobrist ^= ZOBRIST_QUEENSIDE_CASTLING_KEYS[c];
+            }
+        }
+        states.clear();
+        states.reserve(STATE_CAPACITY);
+
+        // state of the initial position (hash is filled in below)
+        StateInfo initial;
+        initial.hash = 0;
+        initial.move = Move();
+        initial.rule50 = static_cast<std::int16_t>(rule50);
+        initial.epSquare = static_cast<std::int8_t>(epSquare);
+        initial.castlingRights = static_cast<std::int8_t>(castlingRights);
+        initial.psqt = 0;
+        initial.phase = 0;
+        states.push_back(initial);
+
+        // initialize zobrist hash and bitboards for all of the peices
+        std::fill(std::begin(peiceBitboards), std::end(peiceBitboards), 0);
+        colorBitboards[0] = 0;
+        colorBitboards[1] = 0;
+        std::fill(std::begin(peiceCounts), std::end(peiceCounts), 0);
+        colorCounts[0] = 0;
+        colorCounts[1] = 0;
+        for (int i = 0; i < 64; ++i) {
+            int peice = peices[i];
+            if (peice) {
+                zobrist ^= ZOBRIST_PEICE_KEYS[peice >> 3][peice % (1 << 3) - 1][i];
+                states.back().psqt += PSQT.score[peice][i];
+                states.back().phase += PSQT.phase[peice];
+                peiceBitboards[peice] |= squareBitboard(i);
+                colorBitboards[peice >> 3] |= squareBitboard(i);
+                ++peiceCounts[peice];
+                ++colorCounts[peice >> 3];
+            }
+        }
+        zobrist ^= enPassantKey();
+        states.back().hash = zobrist;
+        std::fill(std::begin(repetitionFilter), std::end(repetitionFilter), 0);
+        ++repetitionFilter[zobrist & REPETITION_FILTER_MASK];
+
+        // nothing is known about the new position yet
+        if (derivedStates.empty()) {
+            derivedStates.emplace_back();
+        }
+        derivedStates[0].known = 0;
+    }
+
+    // BOARD MEMBERS
+    // Castling rights bits of StateInfo::castlingRights (shifted left by 2 for black)
+    static constexpr int KINGSIDE_CASTLING =  0b01;
+    static constexpr int QUEENSIDE_CASTLING = 0b10;
+
+    // Initial capacity of the state stack (games and searches rarely get longer, it still grows if they do)
+    static constexpr int STATE_CAPACITY = 1024;
+
+    // State of a ply that can't be recovered from the move when it is unmade (the captured peice is stored in the move)
+    struct StateInfo
+    {
+        // zobrist hash of the position
+        uint64 hash;
+
+        // move that led to the position (null for the initial position)
+        Move move;
+
+        // number of half moves since pawn move or capture (half move is one player taking a turn) (used for 50 move rule)
+        std::int16_t rule50;
+
+        // square a pawn has just skipped over by moving two squares (-1 if none)
+        std::int8_t epSquare;
+
+        // KINGSIDE_CASTLING / QUEENSIDE_CASTLING bits for white and black
+        std::int8_t castlingRights;
+
+        // sum of the PSQT scores of every peice (packed middlegame / endgame, see makeScore) and game phase
+        // updated incrementally by makeMove, so unmakeMove restores them by popping the state
+        int psqt;
+        int phase;
+    };
+
+    // one state per ply since initialize, the back is the current position
+    std::vector<StateInfo> states;
+
+    // color and peice type at every square (index [0, 63] -> [a1, h8])
+    int peices[64];
+
+    // total half moves since game start (half move is one player taking a turn)
+    int totalHalfmoves;
+
+    // index of the white and black king (index 0 and 1)
+    int kingIndex[2];
+
+    uint64 zobrist;
+
+    // Flags of the derived state that have been computed
+    static constexpr int CHECKERS_KNOWN = 0b001;
+    static constexpr int MOVES_KNOWN =    0b010;
+    static constexpr int DRAW_KNOWN =     0b100;
+
+    // state derived from the position, computed on first use in a ply (not thread safe, positions are copied per thread)
+    struct DerivedState
+    {
+        int known;
+
+        uint64 checkers;
+
+        bool draw;
+
+        MoveList moves;
+    };
+
+    // derived state of every ply in states (deque so references survive growth, may be longer than states)
+    mutable std::deque<DerivedState> derivedStates;
+
+    // bitboard of squares occupied by every peice and color (indexed by peice value, index 0 unused)
+    uint64 peiceBitboards[15];
+
+    // bitboard of squares occupied by white and black peices (index 0 and 1)
+    uint64 colorBitboards[2];
+
+    // number of peices of every peice and color (indexed by peice value) and of white and black (index 0 and 1)
+    int peiceCounts[15];
+    int colorCounts[2];
+
+    // Number of positions in states whose hash falls in every bucket, a count below 2 rules out a repitition without scanning
+    static constexpr int REPETITION_FILTER_SIZE = 1024;
+    static constexpr uint64 REPETITION_FILTER_MASK = REPETITION_FILTER_SIZE - 1;
+    std::uint16_t repetitionFilter[REPETITION_FILTER_SIZE];
+
+    inline bool canCastleKingside(int c) const noexcept
+    {
+        return states.back().castlingRights & (KINGSIDE_CASTLING << (2 * c));
+    }
+
+    inline bool canCastleQueenside(int c) const noexcept
+    {
+        return states.back().castlingRights & (QUEENSIDE_CASTLING << (2 * c));
+    }
+
+    // castling rights kept when a move starts or ends on the given square (rights of a king or rook that moves or is captured are lost)
+    static constexpr int castlingRightsKept(int square) noexcept
+    {
+        switch (square) {
+            case 0:  return ~QUEENSIDE_CASTLING;
+            case 4:  return ~(KINGSIDE_CASTLING | QUEENSIDE_CASTLING);
+            case 7:  return ~KINGSIDE_CASTLING;
+            case 56: return ~(QUEENSIDE_CASTLING << 2);
+            case 60: return ~((KINGSIDE_CASTLING | QUEENSIDE_CASTLING) << 2);
+            case 63: return ~(KINGSIDE_CASTLING << 2);
+            default: return ~0;
+        }
+    }
+
+    // put the given peice on the given empty square (does not update zobrist hash)
+    inline void placePeice(int square, int peice) noexcept
+    {
+        peices[square] = peice;
+        peiceBitboards[peice] |= squareBitboard(square);
+        colorBitboards[peice >> 3] |= squareBitboard(square);
+        ++peiceCounts[peice];
+        ++colorCounts[peice >> 3];
+    }
+
+    // remove the peice from the given occupied square (does not update zobrist hash)
+    inline void removePeice(int square) noexcept
+    {
+        int peice = peices[square];
+        peices[square] = 0;
+        peiceBitboards[peice] ^= squareBitboard(square);
+        colorBitboards[peice >> 3] ^= squareBitboard(square);
+        --peiceCounts[peice];
+        --colorCounts[peice >> 3];
+    }
+
+    // pseudo legal moves of the side to move Us (0 white, 1 black)
+    template <int Us>
+    void pseudoLegalMoves(MoveList &moves) const
+    {
+        Stats::add(Stats::MOVE_GENERATIONS);
+        constexpr int Them = !Us;
+        constexpr int color = Us << 3;
+        constexpr int forward = Us ? -8 : 8;
+        constexpr uint64 doublePushRank = Us ? RANK_6 : RANK_3;
+        constexpr int castlingRank = 56 * Us;
+
+        uint64 friendly = colorBitboards[Us];
+        uint64 enemies = colorBitboards[Them];
+        uint64 occupied = friendly | enemies;
+        uint64 targets = ~friendly;
+
+        moves.clear();
+
+        // Pawn moves
+        uint64 pawns = peiceBitboards[color + PAWN];
+        uint64 singlePushes = pawnPushes<Us>(pawns) & ~occupied;
+        uint64 doublePushes = pawnPushes<Us>(singlePushes & doublePushRank) & ~occupied;
+
+        while (singlePushes) {
+            int t = popLsb(singlePushes);
+            addPawnMoves<LEGAL, false>(moves, t - forward, t);
+        }
+        while (doublePushes) {
+            int t = popLsb(doublePushes);
+            moves.emplace_back(this, t - 2 * forward, t);
+        }
+        for (uint64 bb = pawns; bb; ) {
+            int s = popLsb(bb);
+            uint64 captures = ATTACKS.pawn[Us][s] & enemies;
+            while (captures) {
+                addPawnMoves<LEGAL, true>(moves, s, popLsb(captures));
+            }
+        }
+
+        // Knight moves
+        for (uint64 bb = peiceBitboards[color + KNIGHT]; bb; ) {
+            int s = popLsb(bb);
+            addMoves(moves, s, ATTACKS.knight[s] & targets);
+        }
+
+        // Sliding peice moves
+        for (uint64 bb = peiceBitboards[color + BISHOP]; bb; ) {
+            int s = popLsb(bb);
+            addMoves(moves, s, ATTACKS.bishop(s, occupied) & targets);
+        }
+        for (uint64 bb = peiceBitboards[color + ROOK]; bb; ) {
+            int s = popLsb(bb);
+            addMoves(moves, s, ATTACKS.rook(s, occupied) & targets);
+        }
+        for (uint64 bb = peiceBitboards[color + QUEEN]; bb; ) {
+            int s = popLsb(bb);
+            addMoves(moves, s, ATTACKS.queen(s, occupied) & targets);
+        }
+
+        // King moves
+        addMoves(moves, kingIndex[Us], ATTACKS.king[kingIndex[Us]] & targets);
+
+        // Castling moves
+        if (canCastleKingside(Us) && !(occupied & (0b01100000ULL << castlingRank))) {
+            moves.emplace_back(this, castlingRank + 4, castlingRank + 6, Move::CASTLE);
+        }
+        if (canCastleQueenside(Us) && !(occupied & (0b00001110ULL << castlingRank))) {
+            moves.emplace_back(this, castlingRank + 4, castlingRank + 2, Move::CASTLE);
+        }
+
+        // En passant moves
+        int epSquare = states.back().epSquare;
+        if (epSquare >= 0) {
+            // Pawns that could capture on the en passant square are the ones an enemy pawn there would attack
+            uint64 capturers = ATTACKS.pawn[Them][epSquare] & pawns;
+            while (capturers) {
+                moves.emplace_back(this, popLsb(capturers), epSquare, Move::EN_PASSANT);
+            }
+        }
+    }
+
+    // legal moves of the given type for the side to move Us (0 white, 1 black)
+    // checkers and pinned peices are found once so that only legal moves are generated
+    template <int Us, GenType Type>
+    void generateMoves(MoveList &moves) const
+    {
+        Stats::add(Stats::MOVE_GENERATIONS);
+        constexpr int Them = !Us;
+        constexpr int color = Us << 3;
+        constexpr int forward = Us ? -8 : 8;
+        constexpr uint64 doublePushRank = Us ? RANK_6 : RANK_3;
+        constexpr uint64 promotionRank = Us ? RANK_1 : RANK_8;
+        constexpr int pawnStartRank = Us ? 6 : 1;
+        constexpr int castlingRank = 56 * Us;
+        constexpr bool captures = Type != QUIETS;
+        constexpr bool quiets = Type != CAPTURES;
+        int king = kingIndex[Us];
+
+        uint64 friendly = colorBitboards[Us];
+        uint64 enemies = colorBitboards[Them];
+        uint64 occupied = friendly | enemies;
+
+        moves.clear();
+
+        // Checkers and pinned peices are computed once for the whole position
+        uint64 checkers = attackers(king, occupied) & enemies;
+        uint64 pinned = pinnedPeices(Us);
+
+        DerivedState &state = derivedStates[states.size() - 1];
+        state.checkers = checkers;
+        state.known |= CHECKERS_KNOWN;
+
+        // Squares the moves of this type may end on (before check / pin restrictions)
+        uint64 typeMask = (captures ? enemies : 0) | (quiets ? ~occupied : 0);
+
+        // King moves (king is removed from the occupancy so it can't hide behind itself from a slider)
+        uint64 occupiedWithoutKing = occupied ^ squareBitboard(king);
+        for (uint64 bb = ATTACKS.king[king] & typeMask; bb; ) {
+            int t = popLsb(bb);
+            if (!(attackers(t, occupiedWithoutKing) & enemies)) {
+                moves.emplace_back(this, king, t);
+            }
+        }
+
+        // Only king moves can escape double check
+        if (checkers & (checkers - 1)) {
+            return;
+        }
+
+        // Other peices must capture the checker or block the check
+        uint64 checkMask = checkers ? ATTACKS.between[king][lsb(checkers)] | checkers : ~0ULL;
+        uint64 targets = typeMask & checkMask;
+
+        // Pawn moves (pushes to the last rank are generated for both types, addPawnMoves picks the promotions)
+        uint64 pawns = peiceBitboards[color + PAWN];
+        uint64 freePawns = pawns & ~pinned;
+        uint64 singlePushes = pawnPushes<Us>(freePawns) & ~occupied;
+        uint64 doublePushes = pawnPushes<Us>(singlePushes & doublePushRank) & ~occupied & checkMask;
+        singlePushes &= checkMask & (quiets ? ~0ULL : promotionRank);
+
+        while (singlePushes) {
+            int t = popLsb(singlePushes);
+            addPawnMoves<Type, false>(moves, t - forward, t);
+        }
+        if constexpr (quiets) {
+            while (doublePushes) {
+                int t = popLsb(doublePushes);
+                moves.emplace_back(this, t - 2 * forward, t);
+            }
+        }
+        if constexpr (captures) {
+            for (uint64 bb = freePawns; bb; ) {
+                int s = popLsb(bb);
+                for (uint64 pawnCaptures = ATTACKS.pawn[Us][s] & enemies & checkMask; pawnCaptures; ) {
+                    addPawnMoves<Type, true>(moves, s, popLsb(pawnCaptures));
+                }
+            }
+        }
+
+        // Pinned pawns can only move along the line of the pin (a pinned pawn can't reach the last rank with a push)
+        for (uint64 bb = pawns & pinned; bb; ) {
+            int s = popLsb(bb);
+            uint64 pinLine = ATTACKS.line[king][s];
+            if constexpr (quiets) {
+                int ahead = s + forward;
+                if (!(occupied & squareBitboard(ahead)) && (pinLine & squareBitboard(ahead))) {
+                    if (checkMask & squareBitboard(ahead)) {
+                        addPawnMoves<Type, false>(moves, s, ahead);
+                    }
+                    int doubleAhead = ahead + forward;
+                    if (s >> 3 == pawnStartRank && !(occupied & squareBitboard(doubleAhead)) && (checkMask & squareBitboard(doubleAhead))) {
+                        moves.emplace_back(this, s, doubleAhead);
+                    }
+                }
+            }
+            if constexpr (captures) {
+                for (uint64 pawnCaptures = ATTACKS.pawn[Us][s] & enemies & checkMask & pinLine; pawnCaptures; ) {
+                    addPawnMoves<Type, true>(moves, s, popLsb(pawnCaptures));
+                }
+            }
+        }
+
+        // Knight moves (a pinned knight can never move)
+        for (uint64 bb = peiceBitboards[color + KNIGHT] & ~pinned; bb; ) {
+            int s = popLsb(bb);
+            addMoves(moves, s, ATTACKS.knight[s] & targets);
+        }
+
+        // Sliding peice moves (pinned sliders stay on the line of the pin)
+        for (uint64 bb = peiceBitboards[color + BISHOP]; bb; ) {
+            int s = popLsb(bb);
+            addMoves(moves, s, ATTACKS.bishop(s, occupied) & targets & pinMask(king, s, pinned));
+        }
+        for (uint64 bb = peiceBitboards[color + ROOK]; bb; ) {
+            int s = popLsb(bb);
+            addMoves(moves, s, ATTACKS.rook(s, occupied) & targets & pinMask(king, s, pinned));
+        }
+        for (uint64 bb = peiceBitboards[color + QUEEN]; bb; ) {
+            int s = popLsb(bb);
+            addMoves(moves, s, ATTACKS.queen(s, occupied) & targets & pinMask(king, s, pinned));
+        }
+
+        // Castling moves (king can't castle out of or through check)
+        if constexpr (Type == QUIETS || Type == LEGAL) {
+            if (!checkers) {
+                if (canCastleKingside(Us) && !(occupied & (0b01100000ULL << castlingRank))
+                    && !(attackers(castlingRank + 5, occupied) & enemies) && !(attackers(castlingRank + 6, occupied) & enemies)) {
+                    moves.emplace_back(this, castlingRank + 4, castlingRank + 6, Move::CASTLE);
+                }
+                if (canCastleQueenside(Us) && !(occupied & (0b00001110ULL << castlingRank))
+                    && !(attackers(castlingRank + 3, occupied) & enemies) && !(attackers(castlingRank + 2, occupied) & enemies)) {
+                    moves.emplace_back(this, castlingRank + 4, castlingRank + 2, Move::CASTLE);
+                }
+            }
+        }
+
+        // En passant moves (rare, so legality is tested directly since removing two pawns from a rank can uncover a check)
+        if constexpr (captures) {
+            int epSquare = states.back().epSquare;
+            if (epSquare >= 0) {
+                for (uint64 capturers = ATTACKS.pawn[Them][epSquare] & pawns; capturers; ) {
+                    Move move(this, popLsb(capturers), epSquare, Move::EN_PASSANT);
+                    if (isLegal(move)) {
+                        moves.push_back(move);
+                    }
+                }
+            }
+        }
+    }
+
+    // pawns of the side Us (0 white, 1 black) moved one rank forward
+    template <int Us>
+    static constexpr uint64 pawnPushes(uint64 pawns) noexcept
+    {
+        return Us ? pawns >> 8 : pawns << 8;
+    }
+
+    // add the pawn moves of the given type from start to target, a move to the last rank is expanded into the promotions
+    // (every promotion of a capture, only the queen promotion of a push for CAPTURES and the others for QUIETS)
+    template <GenType Type, bool Capture>
+    void addPawnMoves(MoveList &moves, int start, int target) const
+    {
+        if (squareBitboard(target) & (RANK_1 | RANK_8)) {
+            if constexpr (Capture || Type != CAPTURES) {
+                moves.emplace_back(this, start, target, KNIGHT);
+                moves.emplace_back(this, start, target, BISHOP);
+                moves.emplace_back(this, start, target, ROOK);
+            }
+            if constexpr (Capture || Type != QUIETS) {
+                moves.emplace_back(this, start, target, QUEEN);
+            }
+        } else {
+            moves.emplace_back(this, start, target);
+        }
+    }
+
+    // zobrist key for the current en passant target if the side to move has a pawn that could capture en passant (0 otherwise)
+    inline uint64 enPassantKey() const noexcept
+    {
+        int epSquare = states.back().epSquare;
+        int c = totalHalfmoves % 2;
+        if (epSquare >= 0 && (ATTACKS.pawn[!c][epSquare] & peiceBitboards[(c << 3) + PAWN])) {
+            return ZOBRIST_EN_PASSANT_KEYS[epSquare % 8];
+        }
+        return 0;
+    }
+
+    // squares a peice on the given square may move to without exposing its king (all squares if not pinned)
+    inline uint64 pinMask(int king, int square, uint64 pinned) const noexcept
+    {
+        return (pinned & squareBitboard(square)) ? ATTACKS.line[king][square] : ~0ULL;
+    }
+
+    // add a move from the given square to every square in the given bitboard
+    void addMoves(MoveList &moves, int start, uint64 targets) const
+    {
+        while (targets) {
+            moves.emplace_back(this, start, popLsb(targets));
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef POSITION_DATABASE_H
+#define POSITION_DATABASE_H
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "Position.hpp"
+
+/**
+ * File of packed positions indexed by zobrist hash
+ * The file is an open addressing hash table (power of two slots, linear probing, at most half full) written once by
+ * PositionDatabaseBuilder and memory mapped by PositionDatabase: a lookup touches one or two records and a scan reads
+ * the records in place without parsing anything
+ */
+
+// A position of the database and its zobrist hash (empty slots have no peices)
+struct PositionRecord
+{
+    uint64 key;
+
+    Position::Packed position;
+};
+
+static_assert(sizeof(PositionRecord) == 40, "Position records should be exactly 40 bytes");
+
+// Header at the start of the file, followed by the slots
+struct PositionDatabaseHeader
+{
+    char magic[8];
+
+    // power of two number of slots
+    uint64 slots;
+
+    // number of stored positions
+    uint64 records;
+
+    uint64 reserved;
+};
+
+inline constexpr char POSITION_DATABASE_MAGIC[8] = {'P', 'O', 'S', 'D', 'B', 0, 0, 1};
+
+// Collects positions in memory and writes them as a database file
+class PositionDatabaseBuilder
+{
+public:
+    PositionDatabaseBuilder() : slots(1024), count(0) {}
+
+    // Add the current position (returns false if a position with the same hash is already stored)
+    bool insert(const Position &position)
+    {
+        return insert(PositionRecord{position.hash(), position.pack()});
+    }
+
+    bool insert(const PositionRecord &record)
+    {
+        if (2 * (count + 1) > slots.size()) {
+            grow();
+        }
+        std::size_t mask = slots.size() - 1;
+        for (std::size_t i = record.key & mask;; i = (i + 1) & mask) {
+            if (!slots[i].position.occupied) {
+                slots[i] = record;
+                ++count;
+                return true;
+            }
+            if (slots[i].key == record.key) {
+                return false;
+            }
+        }
+    }
+
+    // Number of positions added
+    std::size_t size() const noexcept
+    {
+        return count;
+    }
+
+    // Write the database file (throws std::runtime_error if it can't be written)
+    void write(const std::string &path) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        PositionDatabaseHeader header = {};
+        std::memcpy(header.magic, POSITION_DATABASE_MAGIC, sizeof(header.magic));
+        header.slots = slots.size();
+        header.records = count;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(slots.data()), static_cast<std::streamsize>(slots.size() * sizeof(PositionRecord)));
+        if (!file) {
+            throw std::runtime_error("Cannot write " + path + "!");
+        }
+    }
+
+private:
+    std::vector<PositionRecord> slots;
+
+    std::size_t count;
+
+    // Double the number of slots and reinsert every record
+    void grow()
+    {
+        std::vector<PositionRecord> old(2 * slots.size());
+        old.swap(slots);
+        count = 0;
+        for (const PositionRecord &record : old) {
+            if (record.position.occupied) {
+                insert(record);
+            }
+        }
+    }
+};
+
+// Read only, memory mapped database file
+class PositionDatabase
+{
+public:
+    // @throws std::runtime_error if the file can't be mapped or is not a database
+    explicit PositionDatabase(const std::string &path) : file(path, MappedFile::RANDOM)
+    {
+        PositionDatabaseHeader header;
+        if (file.size() < sizeof(header)) {
+            throw std::runtime_error(path + " is not a position database!");
+        }
+        std::memcpy(&header, file.data().data(), sizeof(header));
+        if (std::memcmp(header.magic, POSITION_DATABASE_MAGIC, sizeof(header.magic)) != 0
+            || !header.slots || (header.slots & (header.slots - 1)) || header.records > header.slots / 2
+            || file.size() != sizeof(header) + header.slots * sizeof(PositionRecord)) {
+            throw std::runtime_error(path + " is not a position database!");
+        }
+        // the mapping is page aligned and the header keeps the records 8 byte aligned
+        records = reinterpret_cast<const PositionRecord *>(file.data().data() + sizeof(header));
+        mask = header.slots - 1;
+        count = header.records;
+    }
+
+    // Record of the position with the given hash, nullptr if it is not stored
+    // (probes at most every slot once, so a corrupt file without empty slots can't loop forever)
+    const PositionRecord *find(uint64 key) const noexcept
+    {
+        for (uint64 probe = 0, i = key & mask; probe <= mask; ++probe, i = (i + 1) & mask) {
+            if (!records[i].position.occupied) {
+                return nullptr;
+            }
+            if (records[i].key == key) {
+                return &records[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Number of stored positions
+    std::size_t size() const noexcept
+    {
+        return count;
+    }
+
+    // Call visit with every stored record in file order (records are read in place)
+    template <typename Visitor>
+    void forEach(Visitor &&visit) const
+    {
+        for (uint64 i = 0; i <= mask; ++i) {
+            if (records[i].position.occupied) {
+                visit(records[i]);
+            }
+        }
+    }
+
+private:
+    MappedFile file;
+
+    const PositionRecord *records;
+
+    uint64 mask;
+
+    std::size_t count;
+};
+
+#endif
@@ -0,0 +1,583 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "Position.hpp"
+#include "Tablebases.hpp"
+#include "TranspositionTable.hpp"
+#include "evaluation.hpp"
+
+/**
+ * Limits for a single search (0 means no limit)
+ * The soft time is checked between iterations, the hard time is checked during the search and aborts it
+ */
+struct SearchLimits
+{
+    int depth = 0;
+
+    uint64 nodes = 0;
+
+    // milliseconds after which no new iteration is started
+    int64_t softTime = 0;
+
+    // milliseconds after which the search is aborted
+    int64_t hardTime = 0;
+
+    /**
+     * @param remaining milliseconds left on the clock of the player to move
+     * @param increment milliseconds added to the clock after every move
+     * @param movesToGo moves until the next time control (0 if the rest of the game must be played in the remaining time)
+     * @return limits that spend a fraction of the remaining time on this move
+     */
+    static SearchLimits fromClock(int64_t remaining, int64_t increment, int movesToGo = 0)
+    {
+        SearchLimits limits;
+        int64_t moves = movesToGo > 0 ? std::min(movesToGo, 40) : 30;
+        int64_t overhead = 20;
+        int64_t available = std::max<int64_t>(1, remaining - overhead);
+
+        limits.softTime = std::max<int64_t>(1, available / moves + increment * 3 / 4);
+        limits.hardTime = std::max<int64_t>(1, std::min(available / 2, limits.softTime * 4));
+        limits.softTime = std::min(limits.softTime, limits.hardTime);
+        return limits;
+    }
+};
+
+// Report of a finished iteration of the search
+struct SearchInfo
+{
+    int depth = 0;
+
+    // deepest ply reached (including quiescence search)
+    int selectiveDepth = 0;
+
+    // score in centipawns from the point of view of the player to move (see Search::isMateScore)
+    int score = 0;
+
+    uint64 nodes = 0;
+
+    double seconds = 0;
+
+    // principal variation, first move is the best move
+    std::vector<Position::Move> pv;
+};
+
+/**
+ * Iterative deepening principal variation search with quiescence search
+ * Moves are ordered by the transposition table move, captures by MVV-LVA, killer moves and the history heuristic
+ */
+class Search
+{
+public:
+    typedef Position::Move Move;
+    typedef Position::MoveList MoveList;
+
+    static constexpr int MAX_PLY = 128;
+    static constexpr int INFINITE_SCORE = 32500;
+    static constexpr int MATE = 32000;
+
+    // Scores beyond this are mates in a number of plies
+    static constexpr int MATE_BOUND = MATE - MAX_PLY;
+
+    // Tablebase wins score below mates and above any evaluation
+    static constexpr int TABLEBASE_WIN = MATE_BOUND - MAX_PLY;
+
+    // Called after every completed iteration
+    typedef std::function<void(const SearchInfo &)> Callback;
+
+    /**
+     * @param tt transposition table used by the search (may be shared with other searches)
+     * @param sharedStop stop flag shared by a group of searches (see ParallelSearch), the owner of the group
+     * resets the flag and starts a new transposition table search instead of run
+     */
+    explicit Search(TranspositionTable &tt, std::atomic<bool> *sharedStop = nullptr)
+        : tt(tt), stopped(false), stopSignal(sharedStop ? sharedStop : &stopped), nodes(0), completedDepth(0)
+    {
+        clearHistory();
+    }
+
+    static bool isMateScore(int score) noexcept
+    {
+        return score > MATE_BOUND || score < -MATE_BOUND;
+    }
+
+    // Score of a tablebase result found ply plies from the root (sooner wins score higher)
+    static int tablebaseScore(Tablebases::Wdl wdl, int ply) noexcept
+    {
+        switch (wdl) {
+            case Tablebases::WIN: return TABLEBASE_WIN - ply;
+            case Tablebases::LOSS: return -TABLEBASE_WIN + ply;
+            case Tablebases::CURSED_WIN: return 1;
+            case Tablebases::BLESSED_LOSS: return -1;
+            default: return 0;
+        }
+    }
+
+    // Probe the tablebases during the search (nullptr to stop probing, must not be changed while searching)
+    void setTablebases(Tablebases *tablebases) noexcept
+    {
+        this->tablebases = tablebases;
+    }
+
+    // Ask a running search to stop as soon as possible (safe to call from another thread)
+    void stop() noexcept
+    {
+        stopSignal->store(true, std::memory_order_relaxed);
+    }
+
+    // Nodes searched by the current or last search (safe to call from another thread)
+    uint64 nodeCount() const noexcept
+    {
+        return nodes.load(std::memory_order_relaxed);
+    }
+
+    // Deepest completed iteration of the current or last search (safe to call from another thread)
+    int depthCount() const noexcept
+    {
+        return completedDepth.load(std::memory_order_relaxed);
+    }
+
+    // Forget killer and history tables (for example when starting a new game)
+    void clearHistory() noexcept
+    {
+        std::memset(killers, 0, sizeof(killers));
+        std::memset(history, 0, sizeof(history));
+    }
+
+    /**
+     * Search the position until the limits are reached or stop is called
+     * @param position root position (restored to its original state when the search returns)
+     * @param limits depth / node / time limits
+     * @param callback called with the result of every completed iteration
+     * @param staggered only search the even depths (2, 4, 6...) so a helper thread is a ply ahead of the main thread every other iteration
+     * @return result of the last completed iteration (pv is empty if the position has no legal moves)
+     */
+    SearchInfo run(Position &position, const SearchLimits &limits, const Callback &callback = nullptr, bool staggered = false)
+    {
+        startTime = std::chrono::steady_clock::now();
+        this->limits = limits;
+        if (stopSignal == &stopped) {
+            stopped.store(false, std::memory_order_relaxed);
+            tt.newSearch();
+        }
+        nodes.store(0, std::memory_order_relaxed);
+        completedDepth.store(0, std::memory_order_relaxed);
+        selectiveDepth = 0;
+
+        SearchInfo result;
+        MoveList rootMoves;
+        position.legalMoves(rootMoves);
+        if (rootMoves.empty()) {
+            result.score = position.inCheck() ? -MATE : 0;
+            return result;
+        }
+        result.pv.push_back(rootMoves[0]);
+
+        int maxDepth = limits.depth > 0 ? std::min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+        int score = 0;
+        for (int depth = staggered ? 2 : 1; depth <= maxDepth; depth += staggered ? 2 : 1) {
+            score = aspirationSearch(position, depth, score);
+            if (aborted) {
+                break;
+            }
+
+            completedDepth.store(depth, std::memory_order_relaxed);
+            result.depth = depth;
+            result.selectiveDepth = selectiveDepth;
+            result.score = score;
+            result.nodes = nodeCount();
+            result.seconds = elapsed() / 1000.0;
+            result.pv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+
+            if (callback) {
+                callback(result);
+            }
+
+            // Not enough time or nodes left to start another iteration, or a forced mate was found
+            if ((limits.softTime && elapsed() >= limits.softTime) || (limits.nodes && nodeCount() >= limits.nodes)
+                || (isMateScore(score) && MATE - std::abs(score) <= depth)) {
+                break;
+            }
+        }
+
+        result.nodes = nodeCount();
+        result.seconds = elapsed() / 1000.0;
+        return result;
+    }
+
+private:
+    TranspositionTable &tt;
+
+    std::atomic<bool> stopped;
+
+    // either stopped or the flag shared by a group of searches
+    std::atomic<bool> *stopSignal;
+
+    Tablebases *tablebases = nullptr;
+
+    // set when a limit was hit in the middle of an iteration (its results are discarded)
+    bool aborted;
+
+    SearchLimits limits;
+
+    std::chrono::steady_clock::time_point startTime;
+
+    // only written by the searching thread, atomic so other threads can read the count while searching
+    std::atomic<uint64> nodes;
+
+    std::atomic<int> completedDepth;
+
+    int selectiveDepth;
+
+    // triangular principal variation table
+    Move pvTable[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+
+    // two quiet moves per ply that caused a beta cutoff
+    Move killers[MAX_PLY][2];
+
+    // quiet move cutoff statistics indexed by [side to move][start][target]
+    int history[2][64][64];
+
+    // Ordering scores (higher is searched first)
+    static constexpr int TT_MOVE_SCORE = 1 << 30;
+    static constexpr int CAPTURE_SCORE = 1 << 28;
+    static constexpr int KILLER_SCORE = 1 << 27;
+    static constexpr int HISTORY_MAX = 1 << 20;
+
+    int64_t elapsed() const
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    // Single writer increment (cheaper than an atomic read-modify-write)
+    void countNode() noexcept
+    {
+        nodes.store(nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Check the node limit on every node, the stop flag and the clock every few thousand nodes
+    bool shouldAbort()
+    {
+        if (aborted) {
+            return true;
+        }
+        uint64 count = nodeCount();
+        if (limits.nodes && count >= limits.nodes) {
+            aborted = true;
+        } else if ((count & 2047) == 0) {
+            aborted = stopSignal->load(std::memory_order_relaxed) || (limits.hardTime && elapsed() >= limits.hardTime);
+        }
+        return aborted;
+    }
+
+    // Search with a narrow window around the previous score and widen it when the score falls outside
+    int aspirationSearch(Position &position, int depth, int previous)
+    {
+        aborted = false;
+        if (depth < 5 || isMateScore(previous)) {
+            return negamax(position, depth, 0, -INFINITE_SCORE, INFINITE_SCORE, true);
+        }
+
+        int delta = 25;
+        int alpha = std::max(previous - delta, -INFINITE_SCORE);
+        int beta = std::min(previous + delta, INFINITE_SCORE);
+        while (true) {
+            int score = negamax(position, depth, 0, alpha, beta, true);
+            if (aborted) {
+                return score;
+            }
+            if (score <= alpha) {
+                alpha = std::max(score - delta, -INFINITE_SCORE);
+            } else if (score >= beta) {
+                beta = std::min(score + delta, INFINITE_SCORE);
+            } else {
+                return score;
+            }
+            delta *= 2;
+        }
+    }
+
+    // Mate scores are stored relative to the node in the transposition table and relative to the root in the search
+    static int scoreToTT(int score, int ply) noexcept
+    {
+        return score > MATE_BOUND ? score + ply : score < -MATE_BOUND ? score - ply : score;
+    }
+
+    static int scoreFromTT(int score, int ply) noexcept
+    {
+        return score > MATE_BOUND ? score - ply : score < -MATE_BOUND ? score + ply : score;
+    }
+
+    // Score every move for ordering
+    void scoreMoves(const MoveList &moves, int scores[], uint16 ttMove, int ply, int side) const noexcept
+    {
+        for (int i = 0; i < moves.size(); ++i) {
+            const Move &move = moves[i];
+            if (move.compact() == ttMove) {
+                scores[i] = TT_MOVE_SCORE;
+            } else if (move.captured() || move.promotion()) {
+                // Most valuable victim, least valuable attacker
+                scores[i] = CAPTURE_SCORE + PEICE_VALUES[move.captured() & 0b111] * 8 + PEICE_VALUES[move.promotion()] - (move.moving() & 0b111);
+            } else if (move == killers[ply][0]) {
+                scores[i] = KILLER_SCORE + 1;
+            } else if (move == killers[ply][1]) {
+                scores[i] = KILLER_SCORE;
+            } else {
+                scores[i] = history[side][move.start()][move.target()];
+            }
+        }
+    }
+
+    // Selection sort step: move the best scoring remaining move to index i
+    static void pickMove(MoveList &moves, int scores[], int i) noexcept
+    {
+        int best = i;
+        for (int j = i + 1; j < moves.size(); ++j) {
+            if (scores[j] > scores[best]) {
+                best = j;
+            }
+        }
+        std::swap(moves[i], moves[best]);
+        std::swap(scores[i], scores[best]);
+    }
+
+    // Reward a quiet move that caused a cutoff and punish the quiet moves searched before it
+    void updateQuietStats(const MoveList &moves, int cutoff, int depth, int ply, int side) noexcept
+    {
+        const Move &best = moves[cutoff];
+        if (best != killers[ply][0]) {
+            killers[ply][1] = killers[ply][0];
+            killers[ply][0] = best;
+        }
+
+        int bonus = std::min(depth * depth, 400);
+        for (int i = 0; i <= cutoff; ++i) {
+            const Move &move = moves[i];
+            if (move.captured() || move.promotion()) {
+                continue;
+            }
+            int &entry = history[side][move.start()][move.target()];
+            int change = i == cutoff ? bonus : -bonus;
+            // Gravity keeps the entries bounded by HISTORY_MAX
+            entry += change - entry * std::abs(change) / HISTORY_MAX;
+        }
+    }
+
+    int negamax(Position &position, int depth, int ply, int alpha, int beta, bool pvNode)
+    {
+        pvLength[ply] = 0;
+
+        if (depth <= 0) {
+            return quiescence(position, ply, alpha, beta);
+        }
+
+        // Checked before the node is counted so a node limit is never exceeded
+        if (shouldAbort()) {
+            return 0;
+        }
+        countNode();
+        selectiveDepth = std::max(selectiveDepth, ply);
+        if (ply > 0) {
+            if (position.halfmoveClock() >= 100 || position.isRepetition() || position.isDrawByInsufficientMaterial()) {
+                return 0;
+            }
+            // Mate distance pruning
+            alpha = std::max(alpha, -MATE + ply);
+            beta = std::min(beta, MATE - ply - 1);
+            if (alpha >= beta) {
+                return alpha;
+            }
+            // Exact result of a tablebase endgame, probed only when the 50 move count has just been reset
+            // (the tables assume it is zero)
+            if (tablebases && position.halfmoveClock() == 0 && tablebases->covers(position)) {
+                if (std::optional<Tablebases::Wdl> wdl = tablebases->probeWdl(position)) {
+                    return tablebaseScore(wdl.value(), ply);
+                }
+            }
+        }
+        if (ply >= MAX_PLY - 1) {
+            return evaluate(position);
+        }
+
+        bool inCheck = position.inCheck();
+
+        TranspositionTable::Data entry;
+        bool hit = tt.probe(position.hash(), entry);
+        uint16 ttMove = hit ? entry.move : 0;
+        if (hit && !pvNode && entry.depth >= depth) {
+            int score = scoreFromTT(entry.score, ply);
+            if ((entry.bound == TranspositionTable::BOUND_EXACT)
+                || (entry.bound == TranspositionTable::BOUND_LOWER && score >= beta)
+                || (entry.bound == TranspositionTable::BOUND_UPPER && score <= alpha)) {
+                return score;
+            }
+        }
+
+        int staticEval = inCheck ? -INFINITE_SCORE : hit ? entry.eval : evaluate(position);
+
+        // Reverse futility pruning: far above beta at low depth, assume a quiet move holds the cutoff
+        if (!pvNode && !inCheck && depth <= 6 && !isMateScore(beta) && staticEval - 80 * depth >= beta) {
+            return staticEval;
+        }
+
+        MoveList moves;
+        position.legalMoves(moves);
+        if (moves.empty()) {
+            return inCheck ? -MATE + ply : 0;
+        }
+
+        int scores[MoveList::CAPACITY];
+        scoreMoves(moves, scores, ttMove, ply, position.sideToMove());
+
+        int bestScore = -INFINITE_SCORE;
+        Move bestMove;
+        int bound = TranspositionTable::BOUND_UPPER;
+
+        for (int i = 0; i < moves.size(); ++i) {
+            pickMove(moves, scores, i);
+            const Move &move = moves[i];
+            bool quiet = !move.captured() && !move.promotion();
+
+            position.makeMove(move);
+            tt.prefetch(position.hash());
+            bool givesCheck = position.inCheck();
+            int newDepth = depth - 1 + (givesCheck ? 1 : 0);
+
+            int score;
+            if (i == 0) {
+                score = -negamax(position, newDepth, ply + 1, -beta, -alpha, pvNode);
+            } else {
+                // Late move reductions for quiet moves ordered late
+                int reduction = 0;
+                if (depth >= 3 && quiet && !inCheck && !givesCheck && i >= 3) {
+                    reduction = 1 + (i >= 8) + (depth >= 8);
+                    reduction = std::min(reduction, newDepth - 1);
+                }
+                // Null window search, re-searched with the full window if it might raise alpha
+                score = -negamax(position, newDepth - reduction, ply + 1, -alpha - 1, -alpha, false);
+                if (score > alpha && reduction) {
+                    score = -negamax(position, newDepth, ply + 1, -alpha - 1, -alpha, false);
+                }
+                if (score > alpha && score < beta) {
+                    score = -negamax(position, newDepth, ply + 1, -beta, -alpha, true);
+                }
+            }
+            position.unmakeMove(move);
+
+            if (aborted) {
+                return 0;
+            }
+
+            if (score > bestScore) {
+                bestScore = score;
+                bestMove = move;
+
+                if (score > alpha) {
+                    alpha = score;
+                    bound = TranspositionTable::BOUND_EXACT;
+
+                    pvTable[ply][0] = move;
+                    std::copy(pvTable[ply + 1], pvTable[ply + 1] + pvLength[ply + 1], pvTable[ply] + 1);
+                    pvLength[ply] = pvLength[ply + 1] + 1;
+
+                    if (score >= beta) {
+                        bound = TranspositionTable::BOUND_LOWER;
+                        if (quiet) {
+                            updateQuietStats(moves, i, depth, ply, position.sideToMove());
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+
+        tt.store(position.hash(), depth, scoreToTT(bestScore, ply), bound, bestMove.compact(), inCheck ? 0 : staticEval);
+        return bestScore;
+    }
+
+    // Search captures and promotions (all evasions when in check) until the position is quiet
+    int quiescence(Position &position, int ply, int alpha, int beta)
+    {
+        pvLength[ply] = 0;
+        if (shouldAbort()) {
+            return 0;
+        }
+        countNode();
+        selectiveDepth = std::max(selectiveDepth, ply);
+        if (ply >= MAX_PLY - 1) {
+            return evaluate(position);
+        }
+
+        bool inCheck = position.inCheck();
+
+        TranspositionTable::Data entry;
+        bool hit = tt.probe(position.hash(), entry);
+        if (hit) {
+            int score = scoreFromTT(entry.score, ply);
+            if ((entry.bound == TranspositionTable::BOUND_EXACT)
+                || (entry.bound == TranspositionTable::BOUND_LOWER && score >= beta)
+                || (entry.bound == TranspositionTable::BOUND_UPPER && score <= alpha)) {
+                return score;
+            }
+        }
+
+        int bestScore = -INFINITE_SCORE;
+        if (!inCheck) {
+            // Stand pat: the side to move can usually do at least as well as the static evaluation
+            bestScore = hit ? entry.eval : evaluate(position);
+            if (bestScore >= beta) {
+                return bestScore;
+            }
+            alpha = std::max(alpha, bestScore);
+        }
+
+        // Every evasion when in check, otherwise only captures and queen promotions
+        MoveList moves;
+        if (inCheck) {
+            position.generateMoves<Position::EVASIONS>(moves);
+            if (moves.empty()) {
+                return -MATE + ply;
+            }
+        } else {
+            position.generateMoves<Position::CAPTURES>(moves);
+        }
+
+        int scores[MoveList::CAPACITY];
+        scoreMoves(moves, scores, hit ? entry.move : 0, ply, position.sideToMove());
+
+        for (int i = 0; i < moves.size(); ++i) {
+            pickMove(moves, scores, i);
+            const Move &move = moves[i];
+
+            position.makeMove(move);
+            int score = -quiescence(position, ply + 1, -beta, -alpha);
+            position.unmakeMove(move);
+
+            if (aborted) {
+                return 0;
+            }
+
+            if (score > bestScore) {
+                bestScore = score;
+                if (score > alpha) {
+                    alpha = score;
+                    if (score >= beta) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        return bestScore;
+    }
+};
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "precomputed.hpp"
+
+/**
+ * Counters of the hot paths (move generation, make / unmake move, transposition table probes, rendering)
+ * Only counted when built with CHESSGUI_STATS (the CMake option of the same name), otherwise every call is an empty
+ * inline function and nothing is left in the hot paths
+ * Counters are relaxed atomics shared by all threads, so counting slows down multi threaded searches a little
+ */
+class Stats
+{
+public:
+    enum Counter
+    {
+        MOVE_GENERATIONS,
+        MAKE_MOVES,
+        UNMAKE_MOVES,
+        TT_PROBES,
+        TT_HITS,
+        FRAMES,
+        FRAME_NANOSECONDS,
+        COUNTERS
+    };
+
+#if defined(CHESSGUI_STATS)
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    static void add(Counter counter, uint64 amount = 1) noexcept
+    {
+        if constexpr (ENABLED) {
+            values[counter].fetch_add(amount, std::memory_order_relaxed);
+        }
+    }
+
+    static uint64 get(Counter counter) noexcept
+    {
+        return values[counter].load(std::memory_order_relaxed);
+    }
+
+    static void reset() noexcept
+    {
+        for (std::atomic<uint64> &value : values) {
+            value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Name of the counter in json output
+    static const char *name(Counter counter) noexcept
+    {
+        static constexpr const char *NAMES[COUNTERS] = {
+            "move_generations", "make_moves", "unmake_moves", "tt_probes", "tt_hits", "frames", "frame_nanoseconds"
+        };
+        return NAMES[counter];
+    }
+
+    // Adds the nanoseconds from its construction to its destruction to a counter
+    class Timer
+    {
+    public:
+        explicit Timer(Counter counter) noexcept : counter(counter)
+        {
+            if constexpr (ENABLED) {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~Timer()
+        {
+            if constexpr (ENABLED) {
+                add(counter, static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+            }
+        }
+
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+
+    private:
+        Counter counter;
+
+        std::chrono::steady_clock::time_point start;
+    };
+
+private:
+    static inline std::atomic<uint64> values[COUNTERS] = {};
+};
+
+/**
+ * Json object built one field at a time (for the --json reports of the headless targets)
+ */
+class JsonObject
+{
+public:
+    template <typename T>
+    JsonObject &add(const std::string &key, const T &value)
+    {
+        fields += fields.empty() ? "{" : ", ";
+        fields += quote(key) + ": ";
+        if constexpr (std::is_same_v<T, bool>) {
+            fields += value ? "true" : "false";
+        } else if constexpr (std::is_same_v<T, JsonObject>) {
+            fields += value.str();
+        } else if constexpr (std::is_floating_point_v<T>) {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.6g", static_cast<double>(value));
+            fields += buffer;
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            fields += std::to_string(value);
+        } else {
+            fields += quote(value);
+        }
+        return *this;
+    }
+
+    std::string str() const
+    {
+        return fields.empty() ? "{}" : fields + "}";
+    }
+
+    // Write the object to a file (throws std::runtime_error if it can't be written)
+    void write(const std::string &path) const
+    {
+        std::ofstream file(path);
+        file << str() << '\n';
+        if (!file) {
+            throw std::runtime_error("Cannot write " + path + "!");
+        }
+    }
+
+private:
+    std::string fields;
+
+    static std::string quote(const std::string &text)
+    {
+        std::string quoted = "\"";
+        for (char ch : text) {
+            if (ch == '"' || ch == '\\') {
+                quoted += '\\';
+                quoted += ch;
+            } else if (static_cast<unsigned char>(ch) < 0x20) {
+                char escape[8];
+                std::snprintf(escape, sizeof(escape), "\\u%04x", ch);
+                quoted += escape;
+            } else {
+                quoted += ch;
+            }
+        }
+        return quoted + "\"";
+    }
+};
+
+// Every counter as a json object, with "enabled" false when counting was not compiled in
+inline JsonObject statsJson()
+{
+    JsonObject stats;
+    stats.add("enabled", Stats::ENABLED);
+    for (int i = 0; i < Stats::COUNTERS; ++i) {
+        stats.add(Stats::name(static_cast<Stats::Counter>(i)), Stats::get(static_cast<Stats::Counter>(i)));
+    }
+    uint64 probes = Stats::get(Stats::TT_PROBES);
+    stats.add("tt_hit_rate", probes ? static_cast<double>(Stats::get(Stats::TT_HITS)) / probes : 0.0);
+    return stats;
+}
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef TABLEBASES_H
+#define TABLEBASES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Position.hpp"
+
+#if defined(CHESSGUI_USE_FATHOM)
+extern "C" {
+#include "tbprobe.h"
+}
+#endif
+
+/**
+ * Bounded least recently used map from position hashes to probe results, shared by every search thread
+ * Split into independently locked shards so threads probing different positions rarely wait on each other
+ */
+template <typename Value>
+class LruCache
+{
+public:
+    // @param capacity maximum number of entries (spread over the shards)
+    explicit LruCache(std::size_t capacity = 1 << 16) : shards(SHARDS)
+    {
+        for (Shard &shard : shards) {
+            shard.capacity = std::max<std::size_t>(1, capacity / SHARDS);
+        }
+    }
+
+    // Value cached for the key (the entry becomes the most recently used)
+    std::optional<Value> find(uint64 key)
+    {
+        Shard &shard = shards[key % SHARDS];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.index.find(key);
+        if (found == shard.index.end()) {
+            return std::nullopt;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+        return found->second->second;
+    }
+
+    // Add or replace the value of the key, evicting the least recently used entry of a full shard
+    void insert(uint64 key, const Value &value)
+    {
+        Shard &shard = shards[key % SHARDS];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.index.find(key);
+        if (found != shard.index.end()) {
+            found->second->second = value;
+            shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+            return;
+        }
+        if (shard.index.size() >= shard.capacity) {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+        }
+        shard.entries.emplace_front(key, value);
+        shard.index[key] = shard.entries.begin();
+    }
+
+    void clear()
+    {
+        for (Shard &shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.entries.clear();
+            shard.index.clear();
+        }
+    }
+
+private:
+    static constexpr std::size_t SHARDS = 16;
+
+    struct Shard
+    {
+        std::mutex mutex;
+
+        // most recently used first
+        std::list<std::pair<uint64, Value>> entries;
+
+        std::unordered_map<uint64, typename std::list<std::pair<uint64, Value>>::iterator> index;
+
+        std::size_t capacity;
+    };
+
+    std::vector<Shard> shards;
+};
+
+/**
+ * Syzygy endgame tablebases: win / draw / loss of a position and the best move of a root position
+ * Probing is done by Fathom (https://github.com/jdart1/Fathom), which memory maps the table files, when CMake finds it
+ * (CHESSGUI_USE_FATHOM), otherwise no tables are ever loaded and every probe fails
+ * Results are kept in an LruCache so positions the search keeps revisiting are not decompressed again
+ */
+class Tablebases
+{
+public:
+    // Result of a position for the side to move (cursed wins and blessed losses are draws under the 50 move rule)
+    enum Wdl
+    {
+        LOSS = -2,
+        BLESSED_LOSS = -1,
+        DRAW = 0,
+        CURSED_WIN = 1,
+        WIN = 2
+    };
+
+    // Best move of a root position and its result
+    struct RootResult
+    {
+        Position::Move move;
+
+        Wdl wdl;
+
+        // half moves to the next capture or pawn move on the optimal path
+        int dtz;
+    };
+
+    // @param cacheSize number of probe results kept
+    explicit Tablebases(std::size_t cacheSize = 1 << 16) : cache(cacheSize), largestTable(0) {}
+
+    Tablebases(const Tablebases &) = delete;
+    Tablebases &operator=(const Tablebases &) = delete;
+
+    ~Tablebases()
+    {
+#if defined(CHESSGUI_USE_FATHOM)
+        tb_free();
+#endif
+    }
+
+    /**
+     * Load the tables from the given directories (separated by ':', or ';' on Windows), replacing the loaded ones
+     * Must not be called while searching (Fathom keeps the tables in global state)
+     * @return false if tablebase support was not compiled in or no tables were found
+     */
+    bool load(const std::string &paths)
+    {
+        cache.clear();
+        largestTable = 0;
+#if defined(CHESSGUI_USE_FATHOM)
+        if (paths.empty() || !tb_init(paths.c_str())) {
+            return false;
+        }
+        largestTable = static_cast<int>(TB_LARGEST);
+#else
+        (void)paths;
+#endif
+        return largestTable > 0;
+    }
+
+    // true if tablebase probing was compiled in
+    static constexpr bool available() noexcept
+    {
+#if defined(CHESSGUI_USE_FATHOM)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Most peices (kings included) of the loaded tables, 0 if none are loaded
+    int largest() const noexcept
+    {
+        return largestTable;
+    }
+
+    // true if the position could be in the loaded tables (few enough peices and no castling rights)
+    bool covers(const Position &position) const noexcept
+    {
+        return largestTable && popcount(position.colorBitboard(0) | position.colorBitboard(1)) <= largestTable && !hasCastlingRights(position);
+    }
+
+    /**
+     * Win / draw / loss of the position, ignoring the half moves already played towards the 50 move rule
+     * (safe to call from several threads)
+     * @return nullopt if the position is not in the loaded tables
+     */
+    std::optional<Wdl> probeWdl(const Position &position)
+    {
+        if (!covers(position)) {
+            return std::nullopt;
+        }
+        if (std::optional<signed char> cached = cache.find(position.hash())) {
+            return cached.value() == NOT_FOUND ? std::nullopt : std::optional<Wdl>(static_cast<Wdl>(cached.value()));
+        }
+
+        signed char result = NOT_FOUND;
+#if defined(CHESSGUI_USE_FATHOM)
+        unsigned wdl = tb_probe_wdl(position.colorBitboard(0), position.colorBitboard(1),
+                                    peices(position, Position::KING), peices(position, Position::QUEEN), peices(position, Position::ROOK),
+                                    peices(position, Position::BISHOP), peices(position, Position::KNIGHT), peices(position, Position::PAWN),
+                                    0, 0, epSquare(position), position.sideToMove() == 0);
+        if (wdl != TB_RESULT_FAILED) {
+            result = static_cast<signed char>(static_cast<int>(wdl) - TB_DRAW);
+        }
+#endif
+        cache.insert(position.hash(), result);
+        return result == NOT_FOUND ? std::nullopt : std::optional<Wdl>(static_cast<Wdl>(result));
+    }
+
+    /**
+     * Move that keeps the best result and makes progress under the 50 move rule (lowest distance to zeroing)
+     * Calls are serialized (Fathom's root probe is not thread safe), so probe once before the search rather than in it
+     * @return nullopt if the position is not in the loaded tables or has no legal moves
+     */
+    std::optional<RootResult> probeRoot(const Position &position)
+    {
+        if (!covers(position)) {
+            return std::nullopt;
+        }
+#if defined(CHESSGUI_USE_FATHOM)
+        std::lock_guard<std::mutex> lock(rootMutex);
+        unsigned result = tb_probe_root(position.colorBitboard(0), position.colorBitboard(1),
+                                        peices(position, Position::KING), peices(position, Position::QUEEN), peices(position, Position::ROOK),
+                                        peices(position, Position::BISHOP), peices(position, Position::KNIGHT), peices(position, Position::PAWN),
+                                        static_cast<unsigned>(position.halfmoveClock()), 0, epSquare(position), position.sideToMove() == 0, nullptr);
+        if (result == TB_RESULT_FAILED || result == TB_RESULT_CHECKMATE || result == TB_RESULT_STALEMATE) {
+            return std::nullopt;
+        }
+
+        // Fathom numbers promotions queen 1 to knight 4
+        static constexpr int PROMOTIONS[5] = {0, Position::QUEEN, Position::ROOK, Position::BISHOP, Position::KNIGHT};
+        int start = static_cast<int>(TB_GET_FROM(result));
+        int target = static_cast<int>(TB_GET_TO(result));
+        int promotion = PROMOTIONS[TB_GET_PROMOTES(result)];
+        for (const Position::Move &move : position.legalMoves()) {
+            if (move.start() == start && move.target() == target && move.promotion() == promotion) {
+                return RootResult{move, static_cast<Wdl>(static_cast<int>(TB_GET_WDL(result)) - TB_DRAW), static_cast<int>(TB_GET_DTZ(result))};
+            }
+        }
+#endif
+        return std::nullopt;
+    }
+
+private:
+    // cached for positions that are not in the tables, so failed probes are not repeated either
+    static constexpr signed char NOT_FOUND = -128;
+
+    LruCache<signed char> cache;
+
+    std::mutex rootMutex;
+
+    int largestTable;
+
+    static bool hasCastlingRights(const Position &position) noexcept
+    {
+        return position.castlingRight(0, true) || position.castlingRight(0, false) || position.castlingRight(1, true) || position.castlingRight(1, false);
+    }
+
+    // Peices of the given type of both colors
+    static uint64 peices(const Position &position, int type) noexcept
+    {
+        return position.peiceBitboard(Position::WHITE + type) | position.peiceBitboard(Position::BLACK + type);
+    }
+
+    // En passant square when a capture is possible (Fathom expects 0 otherwise)
+    static unsigned epSquare(const Position &position) noexcept
+    {
+        int square = position.enPassantSquare();
+        int c = position.sideToMove();
+        if (square < 0 || !(ATTACKS.pawn[!c][square] & position.peiceBitboard((c << 3) + Position::PAWN))) {
+            return 0;
+        }
+        return static_cast<unsigned>(square);
+    }
+};
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed size pool of worker threads with a task queue per worker
+ * Idle workers steal tasks from the front of the other workers' queues so uneven tasks stay balanced
+ */
+class ThreadPool
+{
+public:
+    // @param threads number of worker threads (0 uses the number of hardware threads)
+    explicit ThreadPool(int threads = 0) : queued(0), pending(0), stopping(false), nextQueue(0)
+    {
+        if (threads <= 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for (int i = 0; i < threads; ++i) {
+            queues.push_back(std::make_unique<WorkerQueue>());
+        }
+        for (int i = 0; i < threads; ++i) {
+            workers.emplace_back(&ThreadPool::run, this, i);
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Finishes all submitted tasks and joins the workers
+    ~ThreadPool()
+    {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Number of worker threads
+    int size() const noexcept
+    {
+        return static_cast<int>(workers.size());
+    }
+
+    // Queue a task to be run by one of the workers (tasks must not throw)
+    void submit(std::function<void()> task)
+    {
+        WorkerQueue &queue = *queues[nextQueue++ % queues.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        ++pending;
+        ++queued;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+        }
+        wake.notify_one();
+    }
+
+    // Block until every submitted task has finished
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+    }
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+    std::vector<std::thread> workers;
+
+    // guards sleeping / waking of workers and waiters
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    // tasks submitted but not yet started
+    std::atomic<int> queued;
+
+    // tasks submitted but not yet finished
+    std::atomic<int> pending;
+
+    bool stopping;
+
+    std::atomic<unsigned> nextQueue;
+
+    // take a task from the back of the worker's own queue, or steal one from the front of another queue
+    bool popTask(int index, std::function<void()> &task)
+    {
+        int n = static_cast<int>(queues.size());
+        for (int i = 0; i < n; ++i) {
+            WorkerQueue &queue = *queues[(index + i) % n];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (i == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            --queued;
+            return true;
+        }
+        return false;
+    }
+
+    void run(int index)
+    {
+        while (true) {
+            std::function<void()> task;
+            if (popTask(index, task)) {
+                task();
+                if (--pending == 0) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    done.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && queued == 0) {
+                return;
+            }
+        }
+    }
+};
+
+#endif
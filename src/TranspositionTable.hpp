@@ -0,0 +1,219 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "precomputed.hpp"
+#include "Stats.hpp"
+
+/**
+ * Fixed size hash table of search results keyed by the zobrist hash of the position
+ * Entries are grouped into buckets the size of a cache line so a probe touches a single line
+ * Entries are lockless: the key is stored xor'd with the data so a torn write from another thread fails verification
+ */
+class TranspositionTable
+{
+public:
+    // Kind of bound the stored score is
+    static constexpr int BOUND_NONE = 0;
+    static constexpr int BOUND_UPPER = 1;
+    static constexpr int BOUND_LOWER = 2;
+    static constexpr int BOUND_EXACT = BOUND_UPPER | BOUND_LOWER;
+
+    // Search result read from / written to the table
+    struct Data
+    {
+        // compact 16 bit move (see Position::Move::compact), 0 if none
+        uint16 move;
+
+        int score;
+
+        // static evaluation of the position
+        int eval;
+
+        int depth;
+
+        int bound;
+    };
+
+    // @param megabytes size of the table (rounded down to a power of two number of buckets)
+    explicit TranspositionTable(std::size_t megabytes = 16) : generation(0)
+    {
+        resize(megabytes);
+    }
+
+    // Reallocate the table with the given size (clears all entries, must not be called while other threads use the table)
+    void resize(std::size_t megabytes)
+    {
+        std::size_t buckets = 1;
+        while (buckets * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) {
+            buckets *= 2;
+        }
+        table = std::make_unique<Bucket[]>(buckets);
+        mask = buckets - 1;
+        clear();
+    }
+
+    // Remove all entries (must not be called while other threads use the table)
+    void clear()
+    {
+        for (std::size_t i = 0; i <= mask; ++i) {
+            for (Entry &entry : table[i].entries) {
+                entry.keyXorData.store(0, std::memory_order_relaxed);
+                entry.data.store(0, std::memory_order_relaxed);
+            }
+        }
+        generation = 0;
+    }
+
+    // Start a new search so entries from older searches are preferred for replacement
+    void newSearch() noexcept
+    {
+        generation = (generation + 1) & GENERATION_MASK;
+    }
+
+    // Hint the cpu to load the bucket of the given key
+    void prefetch(uint64 key) const noexcept
+    {
+#if defined(__GNUC__)
+        __builtin_prefetch(&table[key & mask]);
+#endif
+    }
+
+    // @return true and fills data if the position with the given key is stored
+    bool probe(uint64 key, Data &data) const noexcept
+    {
+        Stats::add(Stats::TT_PROBES);
+        const Bucket &bucket = table[key & mask];
+        for (const Entry &entry : bucket.entries) {
+            uint64 packed = entry.data.load(std::memory_order_relaxed);
+            if ((entry.keyXorData.load(std::memory_order_relaxed) ^ packed) == key && unpackBound(packed) != BOUND_NONE) {
+                data = unpack(packed);
+                Stats::add(Stats::TT_HITS);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Store a search result for the position with the given key
+     * Replaces the entry for the same position, else the entry with the lowest depth adjusted for age
+     * A lower depth result for the same position keeps the stored move if none is given
+     */
+    void store(uint64 key, int depth, int score, int bound, uint16 move, int eval) noexcept
+    {
+        Bucket &bucket = table[key & mask];
+        Entry *replace = &bucket.entries[0];
+        int replaceWorth = 1 << 30;
+
+        for (Entry &entry : bucket.entries) {
+            uint64 packed = entry.data.load(std::memory_order_relaxed);
+            if ((entry.keyXorData.load(std::memory_order_relaxed) ^ packed) == key) {
+                if (!move) {
+                    move = unpack(packed).move;
+                }
+                // Keep deeper results of the same search unless the new one is exact
+                if (bound != BOUND_EXACT && unpackGeneration(packed) == generation && depth + 2 < unpackDepth(packed)) {
+                    return;
+                }
+                replace = &entry;
+                break;
+            }
+
+            // Worth of keeping an entry: deeper and more recent entries are worth more
+            int age = (generation - unpackGeneration(packed)) & GENERATION_MASK;
+            int worth = unpackDepth(packed) - 8 * age;
+            if (worth < replaceWorth) {
+                replaceWorth = worth;
+                replace = &entry;
+            }
+        }
+
+        uint64 packed = pack(move, score, eval, depth, bound, generation);
+        replace->keyXorData.store(key ^ packed, std::memory_order_relaxed);
+        replace->data.store(packed, std::memory_order_relaxed);
+    }
+
+    // Approximate permille of the table used by the current search (sampled from the first 1000 buckets)
+    int hashfull() const noexcept
+    {
+        std::size_t samples = std::min<std::size_t>(1000, mask + 1);
+        int used = 0;
+        for (std::size_t i = 0; i < samples; ++i) {
+            for (const Entry &entry : table[i].entries) {
+                uint64 packed = entry.data.load(std::memory_order_relaxed);
+                used += unpackBound(packed) != BOUND_NONE && unpackGeneration(packed) == generation;
+            }
+        }
+        return static_cast<int>(used * 1000 / (samples * ENTRIES_PER_BUCKET));
+    }
+
+private:
+    static constexpr int ENTRIES_PER_BUCKET = 4;
+    static constexpr int GENERATION_MASK = 0b111111;
+
+    struct Entry
+    {
+        std::atomic<uint64> keyXorData{0};
+
+        // move [0, 15] | score [16, 31] | eval [32, 47] | depth [48, 55] | bound [56, 57] | generation [58, 63]
+        std::atomic<uint64> data{0};
+    };
+
+    struct alignas(64) Bucket
+    {
+        Entry entries[ENTRIES_PER_BUCKET];
+    };
+
+    static_assert(sizeof(Bucket) == 64, "Bucket should fill exactly one cache line");
+
+    std::unique_ptr<Bucket[]> table;
+
+    std::size_t mask;
+
+    // 6 bit search counter used for aging entries
+    int generation;
+
+    static uint64 pack(uint16 move, int score, int eval, int depth, int bound, int gen) noexcept
+    {
+        return static_cast<uint64>(move)
+             | static_cast<uint64>(static_cast<uint16>(score)) << 16
+             | static_cast<uint64>(static_cast<uint16>(eval)) << 32
+             | static_cast<uint64>(static_cast<std::uint8_t>(depth)) << 48
+             | static_cast<uint64>(bound) << 56
+             | static_cast<uint64>(gen) << 58;
+    }
+
+    static Data unpack(uint64 packed) noexcept
+    {
+        Data data;
+        data.move = static_cast<uint16>(packed);
+        data.score = static_cast<std::int16_t>(packed >> 16);
+        data.eval = static_cast<std::int16_t>(packed >> 32);
+        data.depth = unpackDepth(packed);
+        data.bound = unpackBound(packed);
+        return data;
+    }
+
+    static int unpackDepth(uint64 packed) noexcept
+    {
+        return static_cast<std::int8_t>(packed >> 48);
+    }
+
+    static int unpackBound(uint64 packed) noexcept
+    {
+        return (packed >> 56) & 0b11;
+    }
+
+    static int unpackGeneration(uint64 packed) noexcept
+    {
+        return (packed >> 58) & GENERATION_MASK;
+    }
+};
+
+#endif
@@ -0,0 +1,152 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include "ParallelSearch.hpp"
+#include "Stats.hpp"
+
+static void printUsage()
+{
+    std::cout << "usage: analyze [options] [fen]   search the position (default fen is the starting position)\n"
+              << "options:\n"
+              << "       --depth <n>      stop after n iterations\n"
+              << "       --movetime <ms>  stop after the given number of milliseconds (default 5000)\n"
+              << "       --nodes <n>      stop after searching n nodes\n"
+              << "       --hash <mb>      size of the transposition table (default 16)\n"
+              << "       --threads <n>    search on n threads (0 uses every hardware thread, default 1)\n"
+              << "       --syzygy <dirs>  probe the syzygy tablebases in the given directories (when built with Fathom)\n"
+              << "       --json <file>    also write the result and the performance counters as json\n";
+}
+
+// Score in centipawns or moves to mate
+static std::string scoreToString(int score)
+{
+    if (Search::isMateScore(score)) {
+        int plies = Search::MATE - std::abs(score);
+        return "mate " + std::to_string(score > 0 ? (plies + 1) / 2 : -(plies + 1) / 2);
+    }
+    return "cp " + std::to_string(score);
+}
+
+static void printInfo(const SearchInfo &info)
+{
+    std::cout << "depth " << info.depth << "/" << info.selectiveDepth
+              << "  score " << scoreToString(info.score)
+              << "  nodes " << info.nodes
+              << "  time " << std::fixed << std::setprecision(3) << info.seconds << "s"
+              << "  nps " << static_cast<uint64>(info.seconds > 0 ? info.nodes / info.seconds : 0)
+              << "  pv";
+    for (const Position::Move &move : info.pv) {
+        std::cout << " " << move.toString();
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    std::size_t hashMegabytes = 16;
+    int threads = 1;
+    std::string syzygyPath;
+    std::string jsonPath;
+    SearchLimits limits;
+    limits.hardTime = 5000;
+
+    try {
+        std::vector<std::string> args;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if ((arg == "--depth" || arg == "--movetime" || arg == "--nodes" || arg == "--hash" || arg == "--threads") && i + 1 < argc) {
+                long long value = std::stoll(argv[++i]);
+                if (arg == "--depth") {
+                    limits.depth = static_cast<int>(value);
+                    limits.hardTime = 0;
+                } else if (arg == "--movetime") {
+                    limits.hardTime = value;
+                } else if (arg == "--nodes") {
+                    limits.nodes = static_cast<uint64>(value);
+                    limits.hardTime = 0;
+                } else if (arg == "--threads") {
+                    threads = static_cast<int>(value);
+                } else {
+                    hashMegabytes = static_cast<std::size_t>(std::max(1LL, value));
+                }
+            } else if (arg == "--syzygy" && i + 1 < argc) {
+                syzygyPath = argv[++i];
+            } else if (arg == "--json" && i + 1 < argc) {
+                jsonPath = argv[++i];
+            } else if (arg == "--help") {
+                printUsage();
+                return EXIT_SUCCESS;
+            } else {
+                args.push_back(arg);
+            }
+        }
+
+        // A fen may be passed as one argument or as its space separated fields
+        if (!args.empty()) {
+            fen = args[0];
+            for (std::size_t i = 1; i < args.size(); ++i) {
+                fen += " " + args[i];
+            }
+        }
+
+        Position position(fen);
+        TranspositionTable tt(hashMegabytes);
+        ParallelSearch search(tt, threads);
+        Tablebases tablebases;
+        if (!syzygyPath.empty()) {
+            if (!tablebases.load(syzygyPath)) {
+                std::cerr << (Tablebases::available() ? "no tablebases found in " + syzygyPath : std::string("built without tablebase support")) << std::endl;
+            }
+            search.setTablebases(&tablebases);
+        }
+
+        SearchInfo result = search.run(position, limits, printInfo);
+
+        if (search.threads() > 1) {
+            std::vector<ParallelSearch::ThreadStats> stats = search.threadStats();
+            for (std::size_t i = 0; i < stats.size(); ++i) {
+                std::cout << "thread " << i << "  depth " << stats[i].depth << "  nodes " << stats[i].nodes
+                          << "  nps " << static_cast<uint64>(result.seconds > 0 ? stats[i].nodes / result.seconds : 0) << std::endl;
+            }
+        }
+        std::cout << "nodes " << result.nodes << "  time " << std::fixed << std::setprecision(3) << result.seconds << "s"
+                  << "  nps " << static_cast<uint64>(result.seconds > 0 ? result.nodes / result.seconds : 0) << std::endl;
+        if (result.pv.empty()) {
+            std::cout << (position.inCheck() ? "checkmate" : "stalemate") << std::endl;
+        } else {
+            std::cout << "bestmove " << result.pv[0].toString() << std::endl;
+        }
+
+        if (!jsonPath.empty()) {
+            std::string pv;
+            for (const Position::Move &move : result.pv) {
+                pv += (pv.empty() ? "" : " ") + move.toString();
+            }
+            JsonObject report;
+            report.add("fen", position.asFEN())
+                  .add("depth", result.depth)
+                  .add("seldepth", result.selectiveDepth)
+                  .add("score", scoreToString(result.score))
+                  .add("nodes", result.nodes)
+                  .add("seconds", result.seconds)
+                  .add("nps", static_cast<uint64>(result.seconds > 0 ? result.nodes / result.seconds : 0))
+                  .add("threads", search.threads())
+                  .add("hashfull", tt.hashfull())
+                  .add("bestmove", result.pv.empty() ? std::string("0000") : result.pv[0].toString())
+                  .add("pv", pv)
+                  .add("stats", statsJson())
+                  .write(jsonPath);
+        }
+
+    } catch (const std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,46 @@
+#ifndef ARGUMENTS_H
+#define ARGUMENTS_H
+
+#include <cstddef>
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+/**
+ * Number values of command line arguments for the headless tools
+ * (std::stoi / std::stod accept trailing text and only throw "stoi" or "stod" for the rest)
+ */
+
+// Integer value of a command line argument (throws std::invalid_argument naming the argument if it isn't a whole number)
+inline int parseNumber(const std::string &name, const std::string &value)
+{
+    std::size_t end = 0;
+    int number = 0;
+    try {
+        number = std::stoi(value, &end);
+    } catch (const std::exception &) {
+        end = 0;
+    }
+    if (end == 0 || end != value.size()) {
+        throw std::invalid_argument(name + " should be a number, not \"" + value + "\"");
+    }
+    return number;
+}
+
+// Decimal value of a command line argument (throws std::invalid_argument naming the argument if it isn't a number)
+inline double parseDecimal(const std::string &name, const std::string &value)
+{
+    std::size_t end = 0;
+    double number = 0;
+    try {
+        number = std::stod(value, &end);
+    } catch (const std::exception &) {
+        end = 0;
+    }
+    if (end == 0 || end != value.size()) {
+        throw std::invalid_argument(name + " should be a number, not \"" + value + "\"");
+    }
+    return number;
+}
+
+#endif
@@ -0,0 +1,377 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include <benchmark/benchmark.h>
+
+#include "Search.hpp"
+#include "arguments.hpp"
+#include "perft.hpp"
+
+// Openings, middlegames and endgames the benchmarks are run over (the perft test positions and a few quieter games)
+static const char *BENCH_POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+    "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+    "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+    "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/8 b - - 3 54",
+    "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 80"
+};
+
+static constexpr int BENCH_POSITION_COUNT = sizeof(BENCH_POSITIONS) / sizeof(BENCH_POSITIONS[0]);
+
+static std::vector<Position> benchPositions()
+{
+    return std::vector<Position>(std::begin(BENCH_POSITIONS), std::end(BENCH_POSITIONS));
+}
+
+static void printUsage()
+{
+    std::cout << "usage: bench [options] [google benchmark options]   run the benchmarks (--benchmark_filter=<regex> selects some)\n"
+              << "options:\n"
+              << "       --output <file>      write the results to the given file (default bench_output.txt)\n"
+              << "       --compare <file>     compare the results with an earlier output file, the exit code is non-zero on a regression\n"
+              << "       --tolerance <pct>    slowdown in percent reported as a regression (default 10)\n";
+}
+
+
+// BENCHMARKS
+static void benchLegalMoves(benchmark::State &state)
+{
+    std::vector<Position> positions = benchPositions();
+    Position::MoveList moves;
+    for (auto _ : state) {
+        for (const Position &position : positions) {
+            position.legalMoves(moves);
+            benchmark::DoNotOptimize(moves.size());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_POSITION_COUNT);
+}
+BENCHMARK(benchLegalMoves);
+
+static void benchCaptureMoves(benchmark::State &state)
+{
+    std::vector<Position> positions = benchPositions();
+    Position::MoveList moves;
+    for (auto _ : state) {
+        for (const Position &position : positions) {
+            position.generateMoves<Position::CAPTURES>(moves);
+            benchmark::DoNotOptimize(moves.size());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_POSITION_COUNT);
+}
+BENCHMARK(benchCaptureMoves);
+
+// Every legal move of every position made and unmade (items are make / unmake pairs)
+static void benchMakeUnmakeMove(benchmark::State &state)
+{
+    std::vector<Position> positions = benchPositions();
+    std::vector<Position::MoveList> moves(positions.size());
+    int64_t pairs = 0;
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        positions[i].legalMoves(moves[i]);
+        pairs += moves[i].size();
+    }
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < positions.size(); ++i) {
+            for (const Position::Move &move : moves[i]) {
+                positions[i].makeMove(move);
+                positions[i].unmakeMove(move);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * pairs);
+}
+BENCHMARK(benchMakeUnmakeMove);
+
+// inCheck() is cached for the ply, so the attack test behind it is timed
+static void benchInCheck(benchmark::State &state)
+{
+    std::vector<Position> positions = benchPositions();
+    for (auto _ : state) {
+        for (const Position &position : positions) {
+            benchmark::DoNotOptimize(position.inCheck(position.sideToMove()));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_POSITION_COUNT);
+}
+BENCHMARK(benchInCheck);
+
+// isDraw() is cached for the ply, so the three rules behind it are timed
+static void benchIsDraw(benchmark::State &state)
+{
+    std::vector<Position> positions = benchPositions();
+    for (auto _ : state) {
+        for (const Position &position : positions) {
+            benchmark::DoNotOptimize(position.isDrawByFiftyMoveRule() || position.isDrawByInsufficientMaterial() || position.isDrawByThreefoldRepitition());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_POSITION_COUNT);
+}
+BENCHMARK(benchIsDraw);
+
+static void benchParseFEN(benchmark::State &state)
+{
+    Position position;
+    for (auto _ : state) {
+        for (const char *fen : BENCH_POSITIONS) {
+            position.initialize(fen);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_POSITION_COUNT);
+}
+BENCHMARK(benchParseFEN);
+
+static void benchWriteFEN(benchmark::State &state)
+{
+    std::vector<Position> positions = benchPositions();
+    char buffer[Position::FEN_CAPACITY];
+    for (auto _ : state) {
+        for (const Position &position : positions) {
+            benchmark::DoNotOptimize(position.writeFEN(buffer));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_POSITION_COUNT);
+}
+BENCHMARK(benchWriteFEN);
+
+static void benchEvaluate(benchmark::State &state)
+{
+    std::vector<Position> positions = benchPositions();
+    for (auto _ : state) {
+        for (const Position &position : positions) {
+            benchmark::DoNotOptimize(evaluate(position));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_POSITION_COUNT);
+}
+BENCHMARK(benchEvaluate);
+
+static void benchEvaluateFromScratch(benchmark::State &state)
+{
+    std::vector<Position> positions = benchPositions();
+    for (auto _ : state) {
+        for (const Position &position : positions) {
+            benchmark::DoNotOptimize(evaluateFromScratch(position));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_POSITION_COUNT);
+}
+BENCHMARK(benchEvaluateFromScratch);
+
+// Perft of the starting position to the given depth (items are leaf nodes)
+static void benchPerft(benchmark::State &state)
+{
+    Position position;
+    uint64 nodes = 0;
+    for (auto _ : state) {
+        nodes = perft(position, static_cast<int>(state.range(0)));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(nodes));
+}
+BENCHMARK(benchPerft)->Arg(4)->Unit(benchmark::kMillisecond);
+
+// Single threaded search of every bench position to the given depth, from an empty transposition table and history
+static void benchSearch(benchmark::State &state)
+{
+    std::vector<Position> positions = benchPositions();
+    TranspositionTable tt(16);
+    Search search(tt);
+    SearchLimits limits;
+    limits.depth = static_cast<int>(state.range(0));
+    uint64 nodes = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        tt.clear();
+        search.clearHistory();
+        state.ResumeTiming();
+        nodes = 0;
+        for (Position &position : positions) {
+            nodes += search.run(position, limits).nodes;
+        }
+    }
+    state.counters["nodes"] = static_cast<double>(nodes);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(nodes));
+}
+BENCHMARK(benchSearch)->Arg(8)->Unit(benchmark::kMillisecond);
+
+
+// RESULTS
+// Time of one benchmark in nanoseconds per iteration and its counters
+struct BenchResult
+{
+    double realNanoseconds = 0;
+    double cpuNanoseconds = 0;
+    int64_t iterations = 0;
+
+    std::map<std::string, double> counters;
+};
+
+// Console output that also keeps the results for the output file
+class RecordingReporter : public benchmark::ConsoleReporter
+{
+public:
+    std::vector<std::pair<std::string, BenchResult>> results;
+
+    void ReportRuns(const std::vector<Run> &runs) override
+    {
+        benchmark::ConsoleReporter::ReportRuns(runs);
+        for (const Run &run : runs) {
+            if (run.error_occurred || run.iterations <= 0) {
+                continue;
+            }
+            BenchResult result;
+            result.realNanoseconds = run.real_accumulated_time * 1e9 / run.iterations;
+            result.cpuNanoseconds = run.cpu_accumulated_time * 1e9 / run.iterations;
+            result.iterations = run.iterations;
+            for (const auto &[name, counter] : run.counters) {
+                result.counters[name] = counter.value;
+            }
+            results.emplace_back(run.benchmark_name(), result);
+        }
+    }
+};
+
+// One line per benchmark: name, real and cpu nanoseconds per iteration, iterations and name=value counters
+static void writeResults(const std::string &path, const std::vector<std::pair<std::string, BenchResult>> &results)
+{
+    std::ofstream file(path);
+    file << "# benchmark real_ns cpu_ns iterations [counter=value ...]\n";
+    for (const auto &[name, result] : results) {
+        file << name << ' ' << std::fixed << std::setprecision(1) << result.realNanoseconds << ' ' << result.cpuNanoseconds
+             << ' ' << result.iterations;
+        for (const auto &[counter, value] : result.counters) {
+            file << ' ' << counter << '=' << std::setprecision(0) << value;
+        }
+        file << '\n';
+    }
+    if (!file) {
+        throw std::runtime_error("Cannot write " + path + "!");
+    }
+}
+
+// Reads the results written by writeResults (throws std::runtime_error if the file can't be read)
+static std::map<std::string, BenchResult> readResults(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot read " + path + "!");
+    }
+    std::map<std::string, BenchResult> results;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string name;
+        BenchResult result;
+        if (!(fields >> name >> result.realNanoseconds >> result.cpuNanoseconds >> result.iterations)) {
+            throw std::runtime_error("Malformed line in " + path + ": " + line);
+        }
+        results[name] = result;
+    }
+    return results;
+}
+
+/**
+ * @param baseline results of an earlier build
+ * @param results results of this build
+ * @param tolerance slowdown in percent that is reported as a regression
+ * @return number of benchmarks slower than the baseline by more than the tolerance
+ */
+static int compareResults(const std::map<std::string, BenchResult> &baseline, const std::vector<std::pair<std::string, BenchResult>> &results, double tolerance)
+{
+    int regressions = 0;
+    std::cout << "\n" << std::left << std::setw(32) << "benchmark" << std::right << std::setw(14) << "baseline ns" << std::setw(14) << "ns" << std::setw(10) << "change" << "\n";
+    for (const auto &[name, result] : results) {
+        auto previous = baseline.find(name);
+        if (previous == baseline.end() || previous->second.realNanoseconds <= 0) {
+            std::cout << std::left << std::setw(32) << name << std::right << std::setw(14) << "-" << std::setw(14) << std::fixed << std::setprecision(1) << result.realNanoseconds << std::setw(10) << "new" << "\n";
+            continue;
+        }
+        double change = 100 * (result.realNanoseconds / previous->second.realNanoseconds - 1);
+        bool regression = change > tolerance;
+        regressions += regression;
+        std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << previous->second.realNanoseconds << std::setw(14) << result.realNanoseconds
+                  << std::setw(9) << std::showpos << change << std::noshowpos << "%" << (regression ? "  REGRESSION" : "") << "\n";
+    }
+    return regressions;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string outputPath = "bench_output.txt";
+    std::string baselinePath;
+    double tolerance = 10;
+
+    try {
+        // Own options are taken out, the rest is passed to google benchmark
+        std::vector<char *> args = {argv[0]};
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--output" && i + 1 < argc) {
+                outputPath = argv[++i];
+            } else if (arg == "--compare" && i + 1 < argc) {
+                baselinePath = argv[++i];
+            } else if (arg == "--tolerance" && i + 1 < argc) {
+                tolerance = parseDecimal(arg, argv[++i]);
+            } else if (arg == "--help") {
+                printUsage();
+                return EXIT_SUCCESS;
+            } else {
+                args.push_back(argv[i]);
+            }
+        }
+
+        // Read the baseline first so a bad path fails before the benchmarks run
+        std::map<std::string, BenchResult> baseline;
+        if (!baselinePath.empty()) {
+            baseline = readResults(baselinePath);
+        }
+
+        int benchArgc = static_cast<int>(args.size());
+        benchmark::Initialize(&benchArgc, args.data());
+        if (benchmark::ReportUnrecognizedArguments(benchArgc, args.data())) {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+
+        RecordingReporter reporter;
+        benchmark::RunSpecifiedBenchmarks(&reporter);
+        benchmark::Shutdown();
+
+        writeResults(outputPath, reporter.results);
+        std::cout << "results written to " << outputPath << std::endl;
+
+        if (!baselinePath.empty()) {
+            int regressions = compareResults(baseline, reporter.results, tolerance);
+            std::cout << regressions << " regression" << (regressions == 1 ? "" : "s") << " (tolerance " << tolerance << "%)" << std::endl;
+            return regressions ? EXIT_FAILURE : EXIT_SUCCESS;
+        }
+
+    } catch (const std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
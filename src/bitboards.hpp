@@ -0,0 +1,273 @@
+#ifndef BITBOARDS_H
+#define BITBOARDS_H
+
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "precomputed.hpp"
+
+/**
+ * Bitboards are 64 bit sets of squares where bit i is set if square i [0, 63] -> [a1, h8] is in the set
+ */
+constexpr uint64 FILE_A = 0x0101010101010101ULL;
+constexpr uint64 FILE_H = 0x8080808080808080ULL;
+constexpr uint64 RANK_1 = 0x00000000000000FFULL;
+constexpr uint64 RANK_2 = 0x000000000000FF00ULL;
+constexpr uint64 RANK_3 = 0x0000000000FF0000ULL;
+constexpr uint64 RANK_6 = 0x0000FF0000000000ULL;
+constexpr uint64 RANK_7 = 0x00FF000000000000ULL;
+constexpr uint64 RANK_8 = 0xFF00000000000000ULL;
+
+// Bitboard containing only the given square
+constexpr uint64 squareBitboard(int square) noexcept
+{
+    return 1ULL << square;
+}
+
+// Number of squares in the bitboard
+inline int popcount(uint64 bitboard) noexcept
+{
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(bitboard));
+#else
+    return __builtin_popcountll(bitboard);
+#endif
+}
+
+// Index of the least significant square in the bitboard (bitboard must not be empty)
+inline int lsb(uint64 bitboard) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bitboard);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bitboard);
+#endif
+}
+
+// Removes the least significant square from the bitboard and returns its index (bitboard must not be empty)
+inline int popLsb(uint64 &bitboard) noexcept
+{
+    int square = lsb(bitboard);
+    bitboard &= bitboard - 1;
+    return square;
+}
+
+/**
+ * Precomputed attack sets for every peice type from every square [0, 63] -> [a1, h8]
+ * Knight and king sets are derived from KNIGHT_MOVES and KING_MOVES, sliding peice sets are generated by walking DIRECTION_BOUNDS
+ * Sliding peice attacks are looked up with magic bitboards (or PEXT on cpus with BMI2)
+ */
+class AttackTables
+{
+public:
+    AttackTables()
+    {
+        for (int s = 0; s < 64; ++s) {
+            knight[s] = 0;
+            for (int j = 1; j < KNIGHT_MOVES[s][0]; ++j) {
+                knight[s] |= squareBitboard(KNIGHT_MOVES[s][j]);
+            }
+
+            king[s] = 0;
+            for (int j = 1; j < KING_MOVES[s][0]; ++j) {
+                king[s] |= squareBitboard(KING_MOVES[s][j]);
+            }
+
+            uint64 b = squareBitboard(s);
+            pawn[0][s] = ((b & ~FILE_A) << 7) | ((b & ~FILE_H) << 9);
+            pawn[1][s] = ((b & ~FILE_A) >> 9) | ((b & ~FILE_H) >> 7);
+        }
+
+        initializeSlidingAttacks(rookMagics, rookTable, ROOK_DIRECTIONS, ROOK_OFFSETS);
+        initializeSlidingAttacks(bishopMagics, bishopTable, BISHOP_DIRECTIONS, BISHOP_OFFSETS);
+
+        // Lines and segments between every pair of aligned squares
+        for (int a = 0; a < 64; ++a) {
+            for (int b = 0; b < 64; ++b) {
+                line[a][b] = 0;
+                between[a][b] = 0;
+                if (rook(a, 0) & squareBitboard(b)) {
+                    line[a][b] = (rook(a, 0) & rook(b, 0)) | squareBitboard(a) | squareBitboard(b);
+                    between[a][b] = rook(a, squareBitboard(b)) & rook(b, squareBitboard(a));
+                } else if (bishop(a, 0) & squareBitboard(b)) {
+                    line[a][b] = (bishop(a, 0) & bishop(b, 0)) | squareBitboard(a) | squareBitboard(b);
+                    between[a][b] = bishop(a, squareBitboard(b)) & bishop(b, squareBitboard(a));
+                }
+            }
+        }
+    }
+
+    // Squares attacked by a knight on the given square
+    uint64 knight[64];
+
+    // Squares attacked by a king on the given square
+    uint64 king[64];
+
+    // Squares attacked by a pawn of the given color (index 0 and 1) on the given square
+    uint64 pawn[2][64];
+
+    // Full line (edge to edge) through two aligned squares, empty if the squares are not on a common rank, file or diagonal
+    uint64 line[64][64];
+
+    // Squares strictly between two aligned squares, empty if the squares are not on a common rank, file or diagonal
+    uint64 between[64][64];
+
+    // Squares attacked by a bishop on the given square with the given occupied squares
+    inline uint64 bishop(int square, uint64 occupied) const noexcept
+    {
+        return bishopMagics[square].attacks[bishopMagics[square].index(occupied)];
+    }
+
+    // Squares attacked by a rook on the given square with the given occupied squares
+    inline uint64 rook(int square, uint64 occupied) const noexcept
+    {
+        return rookMagics[square].attacks[rookMagics[square].index(occupied)];
+    }
+
+    // Squares attacked by a queen on the given square with the given occupied squares
+    inline uint64 queen(int square, uint64 occupied) const noexcept
+    {
+        return bishop(square, occupied) | rook(square, occupied);
+    }
+
+private:
+    // Magic bitboard entry for a single square
+    struct Magic
+    {
+        // Relevant occupancy squares (rays without the edge squares)
+        uint64 mask;
+
+        uint64 magic;
+
+        // Start of the attack sets for this square in the shared table
+        uint64 *attacks;
+
+        unsigned shift;
+
+        inline unsigned index(uint64 occupied) const noexcept
+        {
+#if defined(__BMI2__)
+            return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+            return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+        }
+    };
+
+    // Indices of directions in DIRECTION_BOUNDS and corresponding square offsets for sliding peices
+    static constexpr int ROOK_DIRECTIONS[4] = {B, F, L, R};
+    static constexpr int ROOK_OFFSETS[4] = {-8, 8, -1, 1};
+    static constexpr int BISHOP_DIRECTIONS[4] = {BL, FR, BR, FL};
+    static constexpr int BISHOP_OFFSETS[4] = {-9, 9, -7, 7};
+
+    static constexpr uint64 MAGIC_SEEDS[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+
+    Magic rookMagics[64];
+    Magic bishopMagics[64];
+
+    uint64 rookTable[0x19000];
+    uint64 bishopTable[0x1480];
+
+    // Attacks of a sliding peice on the given square found by walking each direction until a blocker or the edge of the board
+    static uint64 slidingAttacks(int square, uint64 occupied, const int directions[4], const int offsets[4]) noexcept
+    {
+        uint64 attacks = 0;
+        for (int d = 0; d < 4; ++d) {
+            int bound = DIRECTION_BOUNDS[square][directions[d]];
+            for (int t = square + offsets[d]; offsets[d] < 0 ? t >= bound : t <= bound; t += offsets[d]) {
+                attacks |= squareBitboard(t);
+                if (occupied & squareBitboard(t)) {
+                    break;
+                }
+            }
+        }
+        return attacks;
+    }
+
+    // Fill the magic entries and attack table for a sliding peice (fancy magic bitboards with a deterministic magic search)
+    static void initializeSlidingAttacks(Magic magics[64], uint64 *table, const int directions[4], const int offsets[4])
+    {
+        uint64 occupancy[4096];
+        uint64 reference[4096];
+#if !defined(__BMI2__)
+        int epoch[4096] = {0};
+        int attempt = 0;
+#endif
+        uint64 *attacks = table;
+
+        for (int s = 0; s < 64; ++s) {
+            Magic &m = magics[s];
+
+            // Edge squares don't affect the attack set unless the peice is on that edge
+            uint64 edges = ((RANK_1 | RANK_8) & ~(RANK_1 << (8 * (s / 8)))) | ((FILE_A | FILE_H) & ~(FILE_A << (s % 8)));
+            m.mask = slidingAttacks(s, 0, directions, offsets) & ~edges;
+            m.shift = 64 - popcount(m.mask);
+            m.attacks = attacks;
+
+            // Enumerate all subsets of the mask (Carry-Rippler) and store reference attack sets
+            int size = 0;
+            uint64 subset = 0;
+            do {
+                occupancy[size] = subset;
+                reference[size] = slidingAttacks(s, subset, directions, offsets);
+#if defined(__BMI2__)
+                m.attacks[m.index(occupancy[size])] = reference[size];
+#endif
+                ++size;
+                subset = (subset - m.mask) & m.mask;
+            } while (subset);
+
+            attacks += size;
+
+#if !defined(__BMI2__)
+            // Seeds per rank known to find magics quickly
+            uint64 seed = MAGIC_SEEDS[s / 8];
+
+            // Search for a magic that maps every subset to an index without destructive collisions
+            for (int i = 0; i < size; ) {
+                do {
+                    m.magic = sparseRandom(seed);
+                } while (popcount((m.mask * m.magic) >> 56) < 6);
+
+                ++attempt;
+                for (i = 0; i < size; ++i) {
+                    unsigned index = m.index(occupancy[i]);
+                    if (epoch[index] < attempt) {
+                        epoch[index] = attempt;
+                        m.attacks[index] = reference[i];
+                    } else if (m.attacks[index] != reference[i]) {
+                        break;
+                    }
+                }
+            }
+#endif
+        }
+    }
+
+    // xorshift64* random number with few bits set (good magic candidates)
+    static uint64 sparseRandom(uint64 &seed) noexcept
+    {
+        uint64 result = ~0ULL;
+        for (int i = 0; i < 3; ++i) {
+            seed ^= seed >> 12;
+            seed ^= seed << 25;
+            seed ^= seed >> 27;
+            result &= seed * 2685821657736338717ULL;
+        }
+        return result;
+    }
+};
+
+// Attack tables shared by all positions (initialized once at program startup)
+inline const AttackTables ATTACKS;
+
+#endif
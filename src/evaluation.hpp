@@ -0,0 +1,43 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include "Position.hpp"
+
+/**
+ * @param position position to evaluate
+ * @return static evaluation of the position in centipawns from the point of view of the player to move
+ * material and piece square tables tapered between middlegame and endgame by the game phase
+ * (the sums are kept by the position as moves are made, see Position::psqtScore)
+ */
+inline int evaluate(const Position &position) noexcept
+{
+    int score = position.psqtScore();
+    int phase = std::min(position.gamePhase(), MAX_PHASE);
+    score = (middlegameScore(score) * phase + endgameScore(score) * (MAX_PHASE - phase)) / MAX_PHASE;
+    return position.sideToMove() ? -score : score;
+}
+
+/**
+ * Same as evaluate, recomputed from every peice on the board instead of the incremental sums (for checking them)
+ */
+inline int evaluateFromScratch(const Position &position) noexcept
+{
+    int middlegame = 0;
+    int endgame = 0;
+    int phase = 0;
+
+    for (int peice = Position::WHITE + Position::PAWN; peice <= Position::BLACK + Position::KING; ++peice) {
+        for (uint64 bb = position.peiceBitboard(peice); bb; ) {
+            int score = PSQT.score[peice][popLsb(bb)];
+            middlegame += middlegameScore(score);
+            endgame += endgameScore(score);
+            phase += PSQT.phase[peice];
+        }
+    }
+
+    phase = std::min(phase, MAX_PHASE);
+    int score = (middlegame * phase + endgame * (MAX_PHASE - phase)) / MAX_PHASE;
+    return position.sideToMove() ? -score : score;
+}
+
+#endif
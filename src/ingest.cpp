@@ -0,0 +1,264 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdlib>
+
+#include "MappedFile.hpp"
+#include "PositionDatabase.hpp"
+#include "ThreadPool.hpp"
+#include "arguments.hpp"
+#include "pgn.hpp"
+
+static void printUsage()
+{
+    std::cout << "usage: ingest [options] <file>   validate every game of a pgn file or every position of an epd file\n"
+              << "options:\n"
+              << "       --output <file>   write \"<hash> <fen>\" of every position (every position of every game for pgn)\n"
+              << "       --database <file> write every distinct position to a binary position database\n"
+              << "       --format <f>      pgn or epd (default from the file extension)\n"
+              << "       --threads <n>     replay on n threads (0 uses every hardware thread, default 0)\n"
+              << "       --batch <n>       games or lines per task (default 256)\n";
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Games or epd lines replayed by one task, and what the task found
+struct Batch
+{
+    std::vector<std::string_view> records;
+
+    // line of the file every record starts on
+    std::vector<std::size_t> lines;
+
+    uint64 positions = 0;
+
+    uint64 invalid = 0;
+
+    // "<hash> <fen>" lines of the positions (only with --output)
+    std::string output;
+
+    // packed positions (only with --database)
+    std::vector<PositionRecord> packed;
+
+    // one message per invalid record
+    std::string errors;
+};
+
+static void appendPosition(std::string &output, Position &position)
+{
+    static const char *HEX = "0123456789abcdef";
+    uint64 hash = position.hash();
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        output += HEX[(hash >> shift) & 0xF];
+    }
+    output += ' ';
+    output += position.asFEN();
+    output += '\n';
+}
+
+// Input format and what to produce for every position
+struct IngestOptions
+{
+    std::string path;
+
+    bool pgn;
+
+    bool text;
+
+    bool database;
+};
+
+static void addPosition(Batch &batch, Position &position, const IngestOptions &options)
+{
+    if (options.text) {
+        appendPosition(batch.output, position);
+    }
+    if (options.database) {
+        batch.packed.push_back(PositionRecord{position.hash(), position.pack()});
+    }
+}
+
+// Replay every record of the batch on its own position
+static void runBatch(Batch &batch, const IngestOptions &options)
+{
+    Position position;
+    for (std::size_t i = 0; i < batch.records.size(); ++i) {
+        try {
+            if (options.pgn) {
+                // Check the whole game before writing any of it
+                std::size_t outputSize = batch.output.size();
+                std::size_t packedSize = batch.packed.size();
+                uint64 positions = 0;
+                try {
+                    replayPgnGame(batch.records[i], position, [&](Position &current) {
+                        ++positions;
+                        addPosition(batch, current, options);
+                    });
+                    validatePosition(position);
+                } catch (...) {
+                    batch.output.resize(outputSize);
+                    batch.packed.resize(packedSize);
+                    throw;
+                }
+                batch.positions += positions;
+            } else {
+                loadEpd(batch.records[i], position);
+                validatePosition(position);
+                ++batch.positions;
+                addPosition(batch, position, options);
+            }
+        } catch (const std::exception &e) {
+            ++batch.invalid;
+            batch.errors += options.path + ":" + std::to_string(batch.lines[i]) + ": " + e.what() + "\n";
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int threads = 0;
+    std::size_t batchSize = 256;
+    std::string outputPath;
+    std::string databasePath;
+    std::string format;
+    std::vector<std::string> args;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if ((arg == "--threads" || arg == "--batch") && i + 1 < argc) {
+                int value = parseNumber(arg, argv[++i]);
+                if (arg == "--threads") {
+                    threads = value;
+                } else {
+                    batchSize = static_cast<std::size_t>(std::max(1, value));
+                }
+            } else if (arg == "--output" && i + 1 < argc) {
+                outputPath = argv[++i];
+            } else if (arg == "--database" && i + 1 < argc) {
+                databasePath = argv[++i];
+            } else if (arg == "--format" && i + 1 < argc) {
+                format = argv[++i];
+            } else {
+                args.push_back(arg);
+            }
+        }
+        if (args.size() != 1) {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+
+        const std::string &path = args[0];
+        if (format.empty()) {
+            format = path.size() >= 4 && path.compare(path.size() - 4, 4, ".epd") == 0 ? "epd" : "pgn";
+        }
+        if (format != "pgn" && format != "epd") {
+            throw std::invalid_argument("Format should be pgn or epd!");
+        }
+        IngestOptions options{path, format == "pgn", !outputPath.empty(), !databasePath.empty()};
+        bool pgn = options.pgn;
+
+        std::ofstream output;
+        if (!outputPath.empty()) {
+            output.open(outputPath, std::ios::binary);
+            if (!output) {
+                throw std::runtime_error("Cannot open " + outputPath + "!");
+            }
+        }
+
+        PositionDatabaseBuilder database;
+        uint64 duplicates = 0;
+
+        MappedFile file(path);
+        ThreadPool pool(threads);
+
+        // Split batches on this thread while the pool replays the previous ones, then write the results in file order
+        // (at most a few batches per worker are in flight so memory stays bounded for any file size)
+        std::vector<Batch> inFlight(pool.size() * 4);
+        std::string_view rest = file.data();
+        std::size_t line = 1;
+        uint64 records = 0;
+        uint64 positions = 0;
+        uint64 invalid = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        bool more = true;
+        while (more) {
+            std::size_t submitted = 0;
+            for (Batch &batch : inFlight) {
+                batch = Batch();
+                while (batch.records.size() < batchSize) {
+                    std::string_view record;
+                    if (pgn) {
+                        PgnGame game;
+                        more = nextPgnGame(rest, line, game);
+                        record = game.text;
+                        batch.lines.push_back(game.line);
+                    } else {
+                        more = nextEpdLine(rest, line, record);
+                        batch.lines.push_back(line++);
+                    }
+                    if (!more) {
+                        batch.lines.pop_back();
+                        break;
+                    }
+                    batch.records.push_back(record);
+                }
+                if (batch.records.empty()) {
+                    break;
+                }
+                ++submitted;
+                pool.submit([&batch, &options] {
+                    runBatch(batch, options);
+                });
+                if (!more) {
+                    break;
+                }
+            }
+            pool.wait();
+
+            for (std::size_t i = 0; i < submitted; ++i) {
+                records += inFlight[i].records.size();
+                positions += inFlight[i].positions;
+                invalid += inFlight[i].invalid;
+                std::cerr << inFlight[i].errors;
+                if (output.is_open()) {
+                    output << inFlight[i].output;
+                }
+                for (const PositionRecord &record : inFlight[i].packed) {
+                    duplicates += !database.insert(record);
+                }
+            }
+        }
+
+        if (options.database) {
+            database.write(databasePath);
+        }
+
+        double seconds = secondsSince(start);
+        std::cout << (pgn ? "games " : "lines ") << records
+                  << "  invalid " << invalid
+                  << "  positions " << positions
+                  << "  time " << std::fixed << std::setprecision(3) << seconds << "s"
+                  << "  " << std::setprecision(1) << (seconds > 0 ? file.size() / seconds / (1024 * 1024) : 0) << " MB/s"
+                  << "  threads " << pool.size() << std::endl;
+        if (options.database) {
+            std::cout << "database " << database.size() << " positions (" << duplicates << " duplicates skipped)" << std::endl;
+        }
+
+        return invalid ? EXIT_FAILURE : EXIT_SUCCESS;
+
+    } catch (const std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        printUsage();
+        return EXIT_FAILURE;
+    }
+}
@@ -1,51 +1,427 @@
 #include <SFML/Graphics.hpp>
-#include "DrawableBoard.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "BoardGrid.hpp"
+#include "EngineThread.hpp"
+#include "PolyglotBook.hpp"
+#include "Stats.hpp"
 
-int main()
+// Window title showing the latest engine output
+static std::string engineTitle(const SearchInfo &info, bool thinking)
 {
-    sf::RenderWindow window(sf::VideoMode(960, 960), "chessgui", sf::Style::Close | sf::Style::Titlebar);
+    std::string title = thinking ? "chessgui - thinking" : "chessgui - analysis";
+    title += "  depth " + std::to_string(info.depth);
+    if (Search::isMateScore(info.score)) {
+        int plies = Search::MATE - std::abs(info.score);
+        title += "  mate " + std::to_string(info.score > 0 ? (plies + 1) / 2 : -(plies + 1) / 2);
+    } else {
+        title += "  score " + std::to_string(info.score);
+    }
+    title += "  pv";
+    for (std::size_t i = 0; i < info.pv.size() && i < 8; ++i) {
+        title += " " + info.pv[i].toString();
+    }
+    return title;
+}
+
+// Counters per second since the previous snapshot (window title overlay toggled with S)
+static std::string statsTitle(const uint64 (&previous)[Stats::COUNTERS], double seconds, uint64 nps)
+{
+    if (!Stats::ENABLED) {
+        return "stats not compiled in (CHESSGUI_STATS)";
+    }
+    auto delta = [&previous](Stats::Counter counter) {
+        return Stats::get(counter) - previous[counter];
+    };
+    auto rate = [seconds](uint64 count) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.2fM/s", seconds > 0 ? count / seconds / 1e6 : 0.0);
+        return std::string(buffer);
+    };
+    char frame[32];
+    uint64 frames = delta(Stats::FRAMES);
+    std::snprintf(frame, sizeof(frame), "%.2fms", frames ? delta(Stats::FRAME_NANOSECONDS) / 1e6 / frames : 0.0);
+    uint64 probes = delta(Stats::TT_PROBES);
+
+    return "frame " + std::string(frame) + " (" + std::to_string(seconds > 0 ? static_cast<uint64>(frames / seconds) : 0) + " fps)"
+         + "  movegen " + rate(delta(Stats::MOVE_GENERATIONS))
+         + "  make " + rate(delta(Stats::MAKE_MOVES))
+         + "  tt hits " + std::to_string(probes ? delta(Stats::TT_HITS) * 100 / probes : 0) + "%"
+         + "  nps " + std::to_string(nps);
+}
+
+// Lines read from standard input on a background thread, so a broadcast can be piped into the gui
+class InputFeed
+{
+public:
+    InputFeed() : shared(std::make_shared<Shared>())
+    {
+        // detached: getline can't be interrupted, the thread ends with the input or the process
+        std::thread([shared = shared] {
+            std::string line;
+            while (std::getline(std::cin, line)) {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->lines.push_back(line);
+            }
+        }).detach();
+    }
+
+    // Take the oldest line read (returns false if there is none)
+    bool poll(std::string &line)
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        if (shared->lines.empty()) {
+            return false;
+        }
+        line = std::move(shared->lines.front());
+        shared->lines.pop_front();
+        return true;
+    }
+
+private:
+    struct Shared
+    {
+        std::mutex mutex;
+        std::deque<std::string> lines;
+    };
+
+    std::shared_ptr<Shared> shared;
+};
+
+/**
+ * Apply a line of the broadcast feed to the grid
+ * "<board> <move>" plays a move in long algebraic notation, "<board> fen <fen>" or "<board> startpos" sets up a new game
+ * @throws std::invalid_argument for a malformed line, an unknown board or an illegal move
+ */
+static void applyFeedLine(BoardGrid &grid, const std::string &line)
+{
+    std::istringstream stream(line);
+    int index;
+    std::string command;
+    if (!(stream >> index >> command)) {
+        throw std::invalid_argument("Expected <board> <move | fen ... | startpos>");
+    }
+    if (index < 0 || index >= grid.size()) {
+        throw std::invalid_argument("No board " + std::to_string(index));
+    }
+
+    DrawableBoard &board = grid.board(index);
+    if (command == "startpos") {
+        board.setPosition("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    } else if (command == "fen") {
+        std::string fen;
+        std::getline(stream >> std::ws, fen);
+        board.setPosition(fen);
+    } else {
+        board.playMove(board.position().moveFromString(command).compact());
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Frame cap while the board is changing (0 = uncapped), or vertical sync with --vsync
+    unsigned frameLimit = 60;
+    bool vsync = false;
+
+    // Grid of several boards (--boards n, --columns n), their starting positions (--fens file, one per line)
+    // and moves piped in on standard input (--feed)
+    int boards = 1;
+    int columns = 0;
+    std::string fenFile;
+    bool feed = false;
+
+    // Polyglot book (--book file.bin) and its Random64 table (--book-keys file) probed before the engine searches
+    std::string bookFile;
+    std::string bookKeys;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--vsync") {
+            vsync = true;
+        } else if (arg == "--fps" && i + 1 < argc) {
+            frameLimit = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--boards" && i + 1 < argc) {
+            boards = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--columns" && i + 1 < argc) {
+            columns = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--fens" && i + 1 < argc) {
+            fenFile = argv[++i];
+        } else if (arg == "--feed") {
+            feed = true;
+        } else if (arg == "--book" && i + 1 < argc) {
+            bookFile = argv[++i];
+        } else if (arg == "--book-keys" && i + 1 < argc) {
+            bookKeys = argv[++i];
+        }
+    }
+
+    // Scale the boards so the grid fits in the 960 pixels of a single board
+    if (!columns) {
+        columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(boards))));
+    }
+    int rows = (boards + columns - 1) / columns;
+    int cells = std::max(columns, rows);
+    float spacing = boards > 1 ? 8.0f : 0.0f;
+    float squareSize = std::max(8.0f, std::floor((960 - spacing * (cells + 1)) / cells / 8));
+    BoardGrid grid(boards, columns, squareSize, spacing);
+
+    if (!fenFile.empty()) {
+        std::ifstream fens(fenFile);
+        std::string fen;
+        for (int i = 0; i < grid.size() && std::getline(fens, fen); ++i) {
+            try {
+                grid.board(i).setPosition(fen);
+            } catch (const std::exception &error) {
+                std::cerr << fenFile << ":" << i + 1 << ": " << error.what() << "\n";
+            }
+        }
+    }
+
+    std::unique_ptr<PolyglotBook> book;
+    if (!bookFile.empty()) {
+        try {
+            book = std::make_unique<PolyglotBook>(bookFile, bookKeys);
+            if (!book->polyglotKeys().isStandard()) {
+                std::cerr << bookKeys << " is not the standard Random64 table, books made by polyglot will not match\n";
+            }
+        } catch (const std::exception &error) {
+            std::cerr << error.what() << "\n";
+        }
+    }
+    std::mt19937 random{std::random_device{}()};
+
+    std::unique_ptr<InputFeed> input;
+    if (feed) {
+        input = std::make_unique<InputFeed>();
+    }
+
+    sf::Vector2u windowSize = grid.pixelSize();
+    sf::RenderWindow window(sf::VideoMode(windowSize.x, windowSize.y), "chessgui", sf::Style::Close | sf::Style::Titlebar);
     auto desktop = sf::VideoMode::getDesktopMode();
     window.setPosition(sf::Vector2i(desktop.width/2 - window.getSize().x/2, desktop.height/2 - window.getSize().y/2 - 50));
-    DrawableBoard board(sf::Vector2f(0, 0), true);
+    if (vsync) {
+        window.setVerticalSyncEnabled(true);
+    } else {
+        window.setFramerateLimit(frameLimit);
+    }
+
+    // The board the mouse and the engine keys act on (the last board clicked)
+    int active = 0;
+
+    // Searches run on the engine thread, the loop below only polls for results
+    EngineThread engine;
+
+    // Id of the request whose best move is played when it finishes (0 if none), the board it is played on and the hash of the searched position
+    int moveRequest = 0;
+    int moveBoard = 0;
+    uint64 moveHash = 0;
+
+    // Id of the running analysis request (0 if analysis is off) and the position it is analysing
+    int analysisRequest = 0;
+    uint64 analysedHash = 0;
 
     bool mouseHold = false;
 
+    // Title set by the engine, followed by the counters of the last second when the stats overlay is on
+    std::string title = "chessgui";
+    bool showStats = false;
+    std::string statsText;
+    uint64 statsSnapshot[Stats::COUNTERS] = {};
+    sf::Clock statsClock;
+    uint64 engineNps = 0;
+    auto setTitle = [&](const std::string &text) {
+        title = text;
+        window.setTitle(showStats ? title + "  |  " + statsText : title);
+    };
+
+    // set when the window contents may have been lost (focus change, etc.)
+    bool windowDirty = true;
+
+    auto handleEvent = [&](const sf::Event &event) {
+        switch (event.type)
+        {
+            case sf::Event::Closed:
+                window.close();
+                break;
+
+            case sf::Event::GainedFocus:
+            case sf::Event::Resized:
+                windowDirty = true;
+                break;
+
+            // Mouse Input
+            case sf::Event::MouseButtonPressed:
+                if (event.mouseButton.button == sf::Mouse::Left) {
+                    sf::Vector2f position((float)event.mouseButton.x, (float)event.mouseButton.y);
+                    int clicked = grid.boardAt(position);
+                    if (clicked < 0) {
+                        break;
+                    }
+                    if (clicked != active) {
+                        // Drop the selection on the board left behind
+                        grid.board(active).deselect();
+                        active = clicked;
+                    }
+                    grid.board(active).mouseDown(grid.toBoard(active, position));
+                    mouseHold = true;
+                }
+                break;
+
+            case sf::Event::MouseMoved:
+                if (mouseHold) {
+                    // Mouse is being held
+                    grid.board(active).mouseDrag(grid.toBoard(active, sf::Vector2f((float)event.mouseMove.x, (float)event.mouseMove.y)));
+                }
+                break;
+
+            case sf::Event::MouseButtonReleased:
+                if (event.mouseButton.button == sf::Mouse::Left && mouseHold) {
+                    grid.board(active).mouseUp(grid.toBoard(active, sf::Vector2f((float)event.mouseButton.x, (float)event.mouseButton.y)));
+                    mouseHold = false;
+                }
+                break;
+
+            case sf::Event::KeyPressed:
+                if (event.key.code == sf::Keyboard::Space && !grid.board(active).gameOver().has_value()) {
+                    // Engine plays a move for the side to move, from the book if the position is in it
+                    std::optional<Position::Move> bookMove;
+                    if (book) {
+                        bookMove = book->probe(grid.board(active).position(), random() | 1);
+                    }
+                    if (bookMove.has_value()) {
+                        moveRequest = 0;
+                        analysisRequest = 0;
+                        engine.cancel();
+                        grid.board(active).playMove(bookMove->compact());
+                        setTitle("chessgui");
+                        break;
+                    }
+                    SearchLimits limits;
+                    limits.softTime = 1000;
+                    limits.hardTime = 3000;
+                    analysisRequest = 0;
+                    moveBoard = active;
+                    moveHash = grid.board(active).position().hash();
+                    moveRequest = engine.startSearch(grid.board(active).position(), limits);
+                } else if (event.key.code == sf::Keyboard::A) {
+                    // Toggle infinite analysis of the displayed position
+                    if (analysisRequest) {
+                        analysisRequest = 0;
+                        engine.cancel();
+                        setTitle("chessgui");
+                    } else {
+                        moveRequest = 0;
+                        analysedHash = grid.board(active).position().hash();
+                        analysisRequest = engine.startSearch(grid.board(active).position(), SearchLimits());
+                    }
+                } else if (event.key.code == sf::Keyboard::S) {
+                    // Toggle the performance counters in the window title
+                    showStats = !showStats;
+                    statsText = "";
+                    for (int i = 0; i < Stats::COUNTERS; ++i) {
+                        statsSnapshot[i] = Stats::get(static_cast<Stats::Counter>(i));
+                    }
+                    statsClock.restart();
+                    setTitle(title);
+                } else if (event.key.code == sf::Keyboard::Escape) {
+                    moveRequest = 0;
+                    analysisRequest = 0;
+                    engine.cancel();
+                    setTitle("chessgui");
+                }
+                break;
+
+            default:
+                break;
+        }
+    };
+
     while (window.isOpen())
     {
-        // Handle events
+        // Handle events (sleep until the next event when neither the boards nor the engine have anything to show)
         sf::Event event;
-        while (window.pollEvent(event))
-        {
-            switch (event.type)
-            {
-                case sf::Event::Closed:
-                    window.close();
+        bool engineBusy = engine.busy();
+        if (!engineBusy && !input && !grid.needsRedraw() && !windowDirty) {
+            if (window.waitEvent(event)) {
+                handleEvent(event);
+            }
+        }
+        while (window.pollEvent(event)) {
+            handleEvent(event);
+        }
+
+        // Moves and new games from the broadcast feed
+        std::string line;
+        while (input && input->poll(line)) {
+            try {
+                applyFeedLine(grid, line);
+            } catch (const std::exception &error) {
+                std::cerr << "feed: " << line << ": " << error.what() << "\n";
             }
         }
 
-        // Mouse Input
-        sf::Vector2i mousePos = sf::Mouse::getPosition(window);
-        if (sf::Mouse::isButtonPressed(sf::Mouse::Left)) {
-            if (mouseHold) {
-                // Mouse is being held
-                board.mouseDrag(sf::Vector2f((float)mousePos.x, (float)mousePos.y));
-            } else {
-                // Mousedown
-                board.mouseDown(sf::Vector2f((float)mousePos.x, (float)mousePos.y));
-                mouseHold = true;
+        // Restart analysis when a move was made on the analysed board
+        if (analysisRequest && grid.board(active).position().hash() != analysedHash) {
+            analysedHash = grid.board(active).position().hash();
+            analysisRequest = engine.startSearch(grid.board(active).position(), SearchLimits());
+        }
+
+        // Engine output (updates of replaced or cancelled requests are dropped)
+        EngineThread::Update update;
+        while (engine.poll(update)) {
+            engineNps = static_cast<uint64>(update.info.seconds > 0 ? update.info.nodes / update.info.seconds : 0);
+            if (update.request == moveRequest) {
+                setTitle(engineTitle(update.info, true));
+                if (update.finished) {
+                    moveRequest = 0;
+                    // The board may have changed since the search started (a move by hand or from the feed)
+                    if (!update.info.pv.empty() && grid.board(moveBoard).position().hash() == moveHash) {
+                        grid.board(moveBoard).playMove(update.info.pv[0].compact());
+                    }
+                    setTitle("chessgui");
+                }
+            } else if (update.request == analysisRequest && !update.finished) {
+                setTitle(engineTitle(update.info, false));
             }
-        
-        } else if (mouseHold) {
-            // Mouseup
-            board.mouseUp(sf::Vector2f((float)mousePos.x, (float)mousePos.y));
-            mouseHold = false;
         }
-        
 
-        window.clear();
-        window.draw(board);
-        window.display();
+        // Refresh the stats overlay once a second
+        if (showStats && statsClock.getElapsedTime().asSeconds() >= 1) {
+            statsText = statsTitle(statsSnapshot, statsClock.restart().asSeconds(), engineNps);
+            for (int i = 0; i < Stats::COUNTERS; ++i) {
+                statsSnapshot[i] = Stats::get(static_cast<Stats::Counter>(i));
+            }
+            setTitle(title);
+        }
+
+        // Only the boards that changed are rendered again, the window just composes their textures
+        if (grid.needsRedraw() || windowDirty) {
+            {
+                Stats::Timer frameTimer(Stats::FRAME_NANOSECONDS);
+                grid.render();
+                window.clear();
+                window.draw(grid);
+            }
+            Stats::add(Stats::FRAMES);
+            window.display();
+            windowDirty = false;
+        } else if (engineBusy || input) {
+            // Waiting on the engine or the feed only, check for their output a few times per frame
+            sf::sleep(sf::milliseconds(5));
+        }
     }
     
     return 0;
-}
\ No newline at end of file
+}
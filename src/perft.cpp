@@ -0,0 +1,209 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cctype>
+
+#include "Stats.hpp"
+#include "arguments.hpp"
+#include "perft.hpp"
+
+static void printUsage()
+{
+    std::cout << "usage: perft [options]                      run the standard test positions and validate node counts\n"
+              << "       perft [options] --deep               run the standard test positions one ply deeper\n"
+              << "       perft [options] <depth> [fen]        count leaf nodes (default fen is the starting position)\n"
+              << "       perft [options] divide <depth> [fen] count leaf nodes below every root move\n"
+              << "options:\n"
+              << "       --threads <n>   count on n threads (0 uses every hardware thread, default 1)\n"
+              << "       --hash <mb>     share a perft hash table of the given size between threads\n"
+              << "       --split <n>     split the tree into tasks n half moves below the root when multi threaded (default 2)\n"
+              << "       --json <file>   also write the results and the performance counters as json\n"
+              << "       -h, --help      print this message\n";
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Nodes, time and speed of a count for the json report
+static JsonObject resultJson(uint64 nodes, double seconds)
+{
+    JsonObject result;
+    result.add("nodes", nodes).add("seconds", seconds).add("nps", static_cast<uint64>(seconds > 0 ? nodes / seconds : 0));
+    return result;
+}
+
+static void printResult(uint64 nodes, double seconds)
+{
+    std::cout << "nodes " << nodes
+              << "  time " << std::fixed << std::setprecision(3) << seconds << "s"
+              << "  nps " << static_cast<uint64>(seconds > 0 ? nodes / seconds : 0) << std::endl;
+}
+
+// Single threaded counting unless threads or a hash table were requested
+struct PerftOptions
+{
+    int threads = 1;
+    std::size_t hashMegabytes = 0;
+    int splitDepth = 2;
+
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<PerftHashTable> hash;
+
+    bool parallel() const
+    {
+        return pool != nullptr;
+    }
+};
+
+static uint64 count(Position &position, int depth, PerftOptions &options)
+{
+    if (options.parallel()) {
+        return parallelPerft(position, depth, *options.pool, options.hash.get(), options.splitDepth);
+    }
+    return perft(position, depth);
+}
+
+// Runs the standard test positions and returns the number of mismatched node counts (results are added to the report)
+static int runTestPositions(bool deep, PerftOptions &options, JsonObject &report)
+{
+    JsonObject positions;
+    int failures = 0;
+    uint64 totalNodes = 0;
+    double totalSeconds = 0;
+
+    for (const PerftTestPosition &test : PERFT_TEST_POSITIONS) {
+        Position position(test.fen);
+        int depth = deep ? test.depth + 1 : test.depth;
+        uint64 expected = deep ? test.deepNodes : test.nodes;
+
+        // Counts from a previous position must not leak into this one
+        if (options.hash) {
+            options.hash = std::make_unique<PerftHashTable>(options.hashMegabytes);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        uint64 nodes = count(position, depth, options);
+        double seconds = secondsSince(start);
+
+        totalNodes += nodes;
+        totalSeconds += seconds;
+
+        bool passed = nodes == expected;
+        failures += !passed;
+
+        std::cout << std::left << std::setw(10) << test.name << " depth " << depth << "  ";
+        printResult(nodes, seconds);
+        if (!passed) {
+            std::cout << "  FAILED: expected " << expected << " nodes" << std::endl;
+        }
+        positions.add(test.name, resultJson(nodes, seconds).add("depth", depth).add("passed", passed));
+    }
+    report.add("positions", positions).add("total", resultJson(totalNodes, totalSeconds)).add("failures", failures);
+
+    std::cout << "total      ";
+    printResult(totalNodes, totalSeconds);
+    std::cout << (failures ? "FAILED " : "passed ") << (6 - failures) << "/6" << std::endl;
+
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string startpos = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    PerftOptions options;
+    std::vector<std::string> args;
+    std::string jsonPath;
+    JsonObject report;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool takesValue = arg == "--threads" || arg == "--hash" || arg == "--split" || arg == "--json";
+            if (takesValue && i + 1 >= argc) {
+                throw std::invalid_argument(arg + " should be followed by a value");
+            }
+            if (arg == "--help" || arg == "-h") {
+                printUsage();
+                return EXIT_SUCCESS;
+            } else if (arg == "--json") {
+                jsonPath = argv[++i];
+            } else if (takesValue) {
+                int value = parseNumber(arg, argv[++i]);
+                if (arg == "--threads") {
+                    options.threads = value;
+                } else if (arg == "--hash") {
+                    options.hashMegabytes = static_cast<std::size_t>(std::max(1, value));
+                } else {
+                    options.splitDepth = value;
+                }
+            } else if (arg.size() > 1 && arg[0] == '-' && arg != "--deep" && !std::isdigit(static_cast<unsigned char>(arg[1]))) {
+                throw std::invalid_argument("unknown option " + arg);
+            } else {
+                args.push_back(arg);
+            }
+        }
+
+        // The report is written on every successful return
+        auto writeReport = [&] {
+            if (!jsonPath.empty()) {
+                report.add("threads", options.pool ? options.pool->size() : 1).add("stats", statsJson()).write(jsonPath);
+            }
+        };
+
+        if (options.threads != 1 || options.hashMegabytes) {
+            options.pool = std::make_unique<ThreadPool>(options.threads);
+            std::cout << "threads " << options.pool->size() << std::endl;
+        }
+        if (options.hashMegabytes) {
+            options.hash = std::make_unique<PerftHashTable>(options.hashMegabytes);
+        }
+
+        if (args.empty() || (args.size() == 1 && args[0] == "--deep")) {
+            int failures = runTestPositions(!args.empty(), options, report);
+            writeReport();
+            return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+        }
+
+        bool divide = args[0] == "divide";
+        std::size_t depthArg = divide ? 1 : 0;
+        if (args.size() <= depthArg || args.size() > depthArg + 2) {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+
+        int depth = parseNumber("depth", args[depthArg]);
+        Position position(args.size() > depthArg + 1 ? args[depthArg + 1] : startpos);
+
+        auto start = std::chrono::steady_clock::now();
+        uint64 nodes = 0;
+        if (divide && depth > 0) {
+            auto counts = options.parallel()
+                ? parallelPerftDivide(position, depth, *options.pool, options.hash.get(), options.splitDepth)
+                : perftDivide(position, depth);
+            for (const auto &[move, moveNodes] : counts) {
+                std::cout << move.toString() << ": " << moveNodes << "\n";
+                nodes += moveNodes;
+            }
+            std::cout << "\n";
+        } else {
+            nodes = count(position, depth, options);
+        }
+        double seconds = secondsSince(start);
+        printResult(nodes, seconds);
+        report.add("fen", position.asFEN()).add("depth", depth).add("total", resultJson(nodes, seconds));
+        writeReport();
+
+    } catch (const std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
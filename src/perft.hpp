@@ -0,0 +1,256 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "Position.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * Lock free hash table of perft subtree node counts keyed by the zobrist hash of the position
+ * Entries store key ^ data next to data so a torn write from another thread is detected and ignored
+ */
+class PerftHashTable
+{
+public:
+    // @param megabytes size of the table (rounded down to a power of two number of entries)
+    explicit PerftHashTable(std::size_t megabytes)
+    {
+        std::size_t entries = 1;
+        while (entries * 2 * sizeof(Entry) <= megabytes * 1024 * 1024) {
+            entries *= 2;
+        }
+        table = std::make_unique<Entry[]>(entries);
+        mask = entries - 1;
+    }
+
+    // @return true and sets nodes if the node count of the position at the given depth is stored
+    bool probe(uint64 key, int depth, uint64 &nodes) const noexcept
+    {
+        const Entry &entry = table[key & mask];
+        uint64 data = entry.data.load(std::memory_order_relaxed);
+        uint64 check = entry.keyXorData.load(std::memory_order_relaxed);
+        if ((check ^ data) != key || static_cast<int>(data & 0xFF) != depth) {
+            return false;
+        }
+        nodes = data >> 8;
+        return true;
+    }
+
+    // store the node count of the position at the given depth (always replaces)
+    void store(uint64 key, int depth, uint64 nodes) noexcept
+    {
+        Entry &entry = table[key & mask];
+        uint64 data = (nodes << 8) | static_cast<uint64>(depth);
+        entry.keyXorData.store(key ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+
+private:
+    struct Entry
+    {
+        std::atomic<uint64> keyXorData{0};
+
+        // node count in bits [8, 63] and depth in bits [0, 7]
+        std::atomic<uint64> data{0};
+    };
+
+    std::unique_ptr<Entry[]> table;
+
+    std::size_t mask;
+};
+
+/**
+ * @param position position to count leaf nodes from (is restored after counting)
+ * @param depth number of half moves to search
+ * @return number of leaf nodes of the legal move tree of the given depth
+ */
+inline uint64 perft(Position &position, int depth)
+{
+    if (depth <= 0) {
+        return 1;
+    }
+
+    Position::MoveList moves;
+    position.legalMoves(moves);
+
+    // Bulk count the last ply
+    if (depth == 1) {
+        return moves.size();
+    }
+
+    uint64 nodes = 0;
+    for (const Position::Move &move : moves) {
+        position.makeMove(move);
+        nodes += perft(position, depth - 1);
+        position.unmakeMove(move);
+    }
+    return nodes;
+}
+
+/**
+ * @param position position to count leaf nodes from (is restored after counting)
+ * @param depth number of half moves to search
+ * @param hash table of previously counted subtrees shared between threads
+ * @return number of leaf nodes of the legal move tree of the given depth
+ */
+inline uint64 perft(Position &position, int depth, PerftHashTable &hash)
+{
+    if (depth <= 1) {
+        return perft(position, depth);
+    }
+
+    uint64 nodes = 0;
+    if (hash.probe(position.hash(), depth, nodes)) {
+        return nodes;
+    }
+
+    Position::MoveList moves;
+    position.legalMoves(moves);
+    for (const Position::Move &move : moves) {
+        position.makeMove(move);
+        nodes += perft(position, depth - 1, hash);
+        position.unmakeMove(move);
+    }
+
+    hash.store(position.hash(), depth, nodes);
+    return nodes;
+}
+
+/**
+ * Counts leaf nodes on multiple threads by splitting the tree into the subtrees below every move sequence of splitDepth half moves
+ * Each task replays its move sequence on its own copy of the position
+ * @param position position to count leaf nodes from
+ * @param depth number of half moves to search (at least 1)
+ * @param pool threads to count on
+ * @param hash optional table of previously counted subtrees shared between threads
+ * @param splitDepth number of half moves to split the tree at (clamped to [1, depth])
+ * @return number of leaf nodes below every legal root move
+ */
+inline std::vector<std::pair<Position::Move, uint64>> parallelPerftDivide(const Position &position, int depth, ThreadPool &pool, PerftHashTable *hash = nullptr, int splitDepth = 2)
+{
+    splitDepth = std::max(1, std::min(splitDepth, depth));
+
+    // Enumerate move sequences of splitDepth half moves (root move index is kept to sum the divide counts)
+    struct Task
+    {
+        int root;
+        std::vector<Position::Move> moves;
+    };
+    std::vector<Task> tasks;
+    Position scratch = position;
+    std::vector<Position::Move> sequence;
+    Position::MoveList rootMoves;
+    scratch.legalMoves(rootMoves);
+
+    std::function<void(int, int)> enumerate = [&](int root, int remaining) {
+        if (remaining == 0) {
+            tasks.push_back({root, sequence});
+            return;
+        }
+        Position::MoveList moves;
+        scratch.legalMoves(moves);
+        for (const Position::Move &move : moves) {
+            sequence.push_back(move);
+            scratch.makeMove(move);
+            enumerate(root, remaining - 1);
+            scratch.unmakeMove(move);
+            sequence.pop_back();
+        }
+    };
+    for (int i = 0; i < rootMoves.size(); ++i) {
+        sequence.assign(1, rootMoves[i]);
+        scratch.makeMove(rootMoves[i]);
+        enumerate(i, splitDepth - 1);
+        scratch.unmakeMove(rootMoves[i]);
+    }
+
+    std::vector<std::atomic<uint64>> counts(rootMoves.size());
+    for (const Task &task : tasks) {
+        pool.submit([&position, &counts, &task, depth, hash] {
+            Position local = position;
+            for (const Position::Move &move : task.moves) {
+                local.makeMove(move);
+            }
+            int remaining = depth - static_cast<int>(task.moves.size());
+            uint64 nodes = hash ? perft(local, remaining, *hash) : perft(local, remaining);
+            counts[task.root] += nodes;
+        });
+    }
+    pool.wait();
+
+    std::vector<std::pair<Position::Move, uint64>> divide;
+    for (int i = 0; i < rootMoves.size(); ++i) {
+        divide.emplace_back(rootMoves[i], counts[i].load());
+    }
+    return divide;
+}
+
+/**
+ * Counts leaf nodes on multiple threads (see parallelPerftDivide)
+ * @return number of leaf nodes of the legal move tree of the given depth
+ */
+inline uint64 parallelPerft(const Position &position, int depth, ThreadPool &pool, PerftHashTable *hash = nullptr, int splitDepth = 2)
+{
+    if (depth <= 1) {
+        Position local = position;
+        return perft(local, depth);
+    }
+
+    uint64 nodes = 0;
+    for (const auto &[move, count] : parallelPerftDivide(position, depth, pool, hash, splitDepth)) {
+        nodes += count;
+    }
+    return nodes;
+}
+
+/**
+ * @param position position to count leaf nodes from (is restored after counting)
+ * @param depth number of half moves to search (at least 1)
+ * @return number of leaf nodes below every legal root move
+ */
+inline std::vector<std::pair<Position::Move, uint64>> perftDivide(Position &position, int depth)
+{
+    std::vector<std::pair<Position::Move, uint64>> divide;
+
+    Position::MoveList moves;
+    position.legalMoves(moves);
+    for (const Position::Move &move : moves) {
+        position.makeMove(move);
+        divide.emplace_back(move, perft(position, depth - 1));
+        position.unmakeMove(move);
+    }
+    return divide;
+}
+
+/**
+ * Standard perft test positions with known node counts
+ * https://www.chessprogramming.org/Perft_Results
+ */
+struct PerftTestPosition
+{
+    const char *name;
+    const char *fen;
+    int depth;
+    uint64 nodes;
+
+    // one ply deeper (used for longer validation runs)
+    uint64 deepNodes;
+};
+
+const PerftTestPosition PERFT_TEST_POSITIONS[6] = {
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609ULL, 119060324ULL},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603ULL, 193690690ULL},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083ULL, 178633661ULL},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292ULL, 706045033ULL},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487ULL, 89941194ULL},
+    {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594ULL, 164075551ULL}
+};
+
+#endif
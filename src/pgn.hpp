@@ -0,0 +1,332 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Position.hpp"
+
+/**
+ * Streaming readers for pgn game files and epd position files
+ * Games and lines are views into the file contents (see MappedFile), nothing is copied until a position is set up
+ */
+
+// A game of a pgn file: its tag pairs and movetext, and the line of the file it starts on (for error messages)
+struct PgnGame
+{
+    std::string_view text;
+
+    std::size_t line;
+};
+
+/**
+ * Split the next game off the front of the remaining pgn text
+ * A game ends where the tag section of the next one starts with a '[' at the start of a line after the movetext
+ * @param rest remaining text, advanced past the game
+ * @param line line number of the start of rest, advanced past the game
+ * @return false when there are no games left
+ */
+inline bool nextPgnGame(std::string_view &rest, std::size_t &line, PgnGame &game)
+{
+    // Skip blank lines before the game
+    while (!rest.empty() && (rest.front() == '\n' || rest.front() == '\r' || rest.front() == ' ' || rest.front() == '\t')) {
+        line += rest.front() == '\n';
+        rest.remove_prefix(1);
+    }
+    if (rest.empty()) {
+        return false;
+    }
+
+    game.line = line;
+    bool inMovetext = false;
+    std::size_t position = 0;
+    while (position < rest.size()) {
+        std::size_t end = rest.find('\n', position);
+        if (end == std::string_view::npos) {
+            end = rest.size();
+        }
+        char first = rest[position];
+        if (first == '[' && inMovetext) {
+            break;
+        }
+        if (first != '[' && first != '\r' && first != '\n' && first != '%') {
+            inMovetext = true;
+        }
+        position = end + 1;
+        ++line;
+    }
+
+    position = std::min(position, rest.size());
+    game.text = rest.substr(0, position);
+    rest.remove_prefix(position);
+    return true;
+}
+
+/**
+ * Value of the tag with the given name in the tag section of a game (ex FEN for "[FEN "...""])
+ * @return false if the game has no such tag
+ */
+inline bool pgnTag(std::string_view game, std::string_view name, std::string_view &value)
+{
+    std::size_t position = 0;
+    while (position < game.size() && game[position] == '[') {
+        std::size_t end = game.find('\n', position);
+        std::string_view tag = game.substr(position + 1, end == std::string_view::npos ? std::string_view::npos : end - position - 1);
+
+        std::size_t open = tag.find('"');
+        std::size_t close = tag.rfind('"');
+        if (open != std::string_view::npos && close > open && tag.substr(0, tag.find_first_of(" \t")) == name) {
+            value = tag.substr(open + 1, close - open - 1);
+            return true;
+        }
+        if (end == std::string_view::npos) {
+            break;
+        }
+        position = end + 1;
+    }
+    return false;
+}
+
+/**
+ * Set up the start position of a game and replay its main line, calling visit with the position before the first move
+ * and after every move (variations, comments, nags and move numbers are skipped, the result or the end of the text ends the game)
+ * @return number of moves played
+ * @throws std::invalid_argument for a malformed start position or an illegal or ambiguous move (the message names the move number)
+ */
+template <typename Visitor>
+int replayPgnGame(std::string_view game, Position &position, Visitor &&visit)
+{
+    std::string_view fen;
+    if (pgnTag(game, "FEN", fen)) {
+        position.initialize(fen);
+    } else {
+        position.initialize("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    }
+    visit(position);
+
+    // Movetext starts after the last tag pair
+    std::size_t i = 0;
+    while (i < game.size() && game[i] == '[') {
+        std::size_t end = game.find('\n', i);
+        i = end == std::string_view::npos ? game.size() : end + 1;
+    }
+
+    int moves = 0;
+    int variationDepth = 0;
+    while (i < game.size()) {
+        char ch = game[i];
+        if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == '.') {
+            ++i;
+        } else if (ch == '{') {
+            // Comment up to the closing brace
+            std::size_t end = game.find('}', i);
+            i = end == std::string_view::npos ? game.size() : end + 1;
+        } else if (ch == ';' || (ch == '%' && (i == 0 || game[i - 1] == '\n'))) {
+            // Comment or escape up to the end of the line
+            std::size_t end = game.find('\n', i);
+            i = end == std::string_view::npos ? game.size() : end + 1;
+        } else if (ch == '(') {
+            ++variationDepth;
+            ++i;
+        } else if (ch == ')') {
+            variationDepth = std::max(0, variationDepth - 1);
+            ++i;
+        } else {
+            std::size_t end = game.find_first_of(" \t\r\n{}();", i);
+            std::string_view token = game.substr(i, end == std::string_view::npos ? std::string_view::npos : end - i);
+            i = end == std::string_view::npos ? game.size() : end;
+            if (variationDepth || token.front() == '$') {
+                continue;
+            }
+            if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+                break;
+            }
+
+            // Move number, possibly run together with the move (ex 12., 12..., 12.e4)
+            if (token.front() >= '1' && token.front() <= '9') {
+                std::size_t number = token.find_first_not_of("0123456789");
+                if (number == std::string_view::npos || token[number] != '.') {
+                    throw std::invalid_argument("Unrecognised token " + std::string(token) + " after move " + std::to_string(position.halfmoveNumber() / 2 + 1) + "!");
+                }
+                token.remove_prefix(token.find_first_not_of('.', number) == std::string_view::npos ? token.size() : token.find_first_not_of('.', number));
+                if (token.empty()) {
+                    continue;
+                }
+            }
+
+            Position::Move move;
+            try {
+                move = position.moveFromSAN(token);
+            } catch (const std::invalid_argument &e) {
+                throw std::invalid_argument(std::string(e.what()) + " (move " + std::to_string(position.halfmoveNumber() / 2 + 1) + (position.sideToMove() ? "...)" : ".)"));
+            }
+            position.makeMove(move);
+            ++moves;
+            visit(position);
+        }
+    }
+    return moves;
+}
+
+/**
+ * Write a game as pgn: the tag pairs in the given order, then the moves in SAN
+ * with move numbers, wrapped at 80 chars, and the result
+ * @param start position before the first move (SetUp and FEN tags are added when it is not the standard starting position)
+ * @param moves moves played from the start position (must be legal)
+ * @param result 1-0, 0-1, 1/2-1/2 or *
+ */
+inline std::string writePgnGame(const std::vector<std::pair<std::string, std::string>> &tags, const Position &start,
+                                const std::vector<Position::Move> &moves, std::string_view result)
+{
+    std::string pgn;
+    auto addTag = [&pgn](std::string_view name, std::string_view value) {
+        pgn += '[';
+        pgn += name;
+        pgn += " \"";
+        for (char ch : value) {
+            if (ch == '"' || ch == '\\') {
+                pgn += '\\';
+            }
+            pgn += ch;
+        }
+        pgn += "\"]\n";
+    };
+    for (const auto &tag : tags) {
+        addTag(tag.first, tag.second);
+    }
+    std::string fen = start.asFEN();
+    if (fen != "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1") {
+        addTag("SetUp", "1");
+        addTag("FEN", fen);
+    }
+    pgn += '\n';
+
+    Position position = start;
+    std::size_t lineStart = pgn.size();
+    auto addToken = [&pgn, &lineStart](const std::string &token) {
+        if (pgn.size() > lineStart && pgn.size() - lineStart + 1 + token.size() > 80) {
+            pgn += '\n';
+            lineStart = pgn.size();
+        } else if (pgn.size() > lineStart) {
+            pgn += ' ';
+        }
+        pgn += token;
+    };
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        int number = position.halfmoveNumber() / 2 + 1;
+        if (!position.sideToMove()) {
+            addToken(std::to_string(number) + ".");
+        } else if (i == 0) {
+            addToken(std::to_string(number) + "...");
+        }
+        addToken(position.moveToSAN(moves[i]));
+        position.makeMove(moves[i]);
+    }
+    addToken(std::string(result));
+    pgn += "\n\n";
+    return pgn;
+}
+
+/**
+ * Split the next non empty line off the front of the remaining epd text
+ * @param rest remaining text, advanced past the line
+ * @param line line number of the start of rest, set to the line number of the returned line
+ * @return false when there are no lines left
+ */
+inline bool nextEpdLine(std::string_view &rest, std::size_t &line, std::string_view &epd)
+{
+    while (!rest.empty()) {
+        std::size_t end = rest.find('\n');
+        epd = rest.substr(0, end);
+        rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+        ++line;
+
+        if (!epd.empty() && epd.back() == '\r') {
+            epd.remove_suffix(1);
+        }
+        if (epd.find_first_not_of(" \t") != std::string_view::npos) {
+            --line;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Set up the position of an epd line: the first four fen fields followed by operations (ex "bm e4; id "1";")
+ * The halfmove clock and fullmove number are taken from the hmvc and fmvn operations if present
+ * @return the operations after the position
+ * @throws std::invalid_argument for a malformed position
+ */
+inline std::string_view loadEpd(std::string_view epd, Position &position)
+{
+    std::size_t end = 0;
+    for (int field = 0; field < 4; ++field) {
+        std::size_t start = epd.find_first_not_of(" \t", end);
+        if (start == std::string_view::npos) {
+            throw std::invalid_argument("Epd should start with the 4 fen fields of the position!");
+        }
+        end = std::min(epd.find_first_of(" \t", start), epd.size());
+    }
+    std::string_view fen = epd.substr(0, end);
+    std::string_view operations = epd.substr(std::min(epd.find_first_not_of(" \t", end), epd.size()));
+
+    // Clocks are written as operations, they are the last two fields of a fen
+    auto operation = [operations](std::string_view name) {
+        std::size_t found = operations.find(name);
+        while (found != std::string_view::npos && found && operations[found - 1] != ' ' && operations[found - 1] != ';') {
+            found = operations.find(name, found + 1);
+        }
+        if (found == std::string_view::npos) {
+            return std::string_view();
+        }
+        std::size_t start = operations.find_first_not_of(' ', found + name.size());
+        std::size_t stop = operations.find_first_of(" ;", start);
+        return start == std::string_view::npos ? std::string_view() : operations.substr(start, stop - start);
+    };
+    std::string_view halfmoveClock = operation("hmvc");
+    std::string_view fullmoveNumber = operation("fmvn");
+    if (halfmoveClock.empty() && fullmoveNumber.empty()) {
+        position.initialize(fen);
+        return operations;
+    }
+
+    char buffer[Position::FEN_CAPACITY + 32];
+    std::size_t length = std::min(fen.size(), Position::FEN_CAPACITY);
+    std::string_view clocks[2] = {halfmoveClock.empty() ? "0" : halfmoveClock, fullmoveNumber.empty() ? "1" : fullmoveNumber};
+    std::copy(fen.begin(), fen.begin() + length, buffer);
+    for (std::string_view clock : clocks) {
+        clock = clock.substr(0, 15);
+        buffer[length++] = ' ';
+        std::copy(clock.begin(), clock.end(), buffer + length);
+        length += clock.size();
+    }
+    position.initialize(std::string_view(buffer, length));
+    return operations;
+}
+
+/**
+ * Check that a position can arise in a game: one king per side, no pawns on the first or last rank
+ * and the side that just moved is not in check
+ * @throws std::invalid_argument naming the first problem found
+ */
+inline void validatePosition(const Position &position)
+{
+    if (position.peiceCount(Position::WHITE + Position::KING) != 1 || position.peiceCount(Position::BLACK + Position::KING) != 1) {
+        throw std::invalid_argument("Position should have exactly one king of each color!");
+    }
+    uint64 pawns = position.peiceBitboard(Position::WHITE + Position::PAWN) | position.peiceBitboard(Position::BLACK + Position::PAWN);
+    if (pawns & (RANK_1 | RANK_8)) {
+        throw std::invalid_argument("Position has pawns on the first or last rank!");
+    }
+    if (position.inCheck(!position.sideToMove())) {
+        throw std::invalid_argument("Side that is not to move is in check!");
+    }
+}
+
+#endif
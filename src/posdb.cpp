@@ -0,0 +1,68 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include "PositionDatabase.hpp"
+
+static void printUsage()
+{
+    std::cout << "usage: posdb <database>            print the number of positions\n"
+              << "       posdb <database> <fen>      look up the position\n"
+              << "       posdb <database> --dump     write \"<hash> <fen>\" of every position\n"
+              << "databases are written by ingest --database\n";
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 3) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    try {
+        PositionDatabase database(argv[1]);
+        if (argc == 2) {
+            std::cout << "positions " << database.size() << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        std::string arg = argv[2];
+        if (arg == "--dump") {
+            auto start = std::chrono::steady_clock::now();
+            Position position;
+            char fen[Position::FEN_CAPACITY];
+            database.forEach([&](const PositionRecord &record) {
+                position.initialize(record.position);
+                position.writeFEN(fen);
+                std::cout << std::hex << std::setw(16) << std::setfill('0') << record.key << std::dec << ' ' << fen << '\n';
+            });
+            std::cerr << "positions " << database.size() << "  time " << std::fixed << std::setprecision(3) << secondsSince(start) << "s" << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        Position position(arg);
+        const PositionRecord *record = database.find(position.hash());
+        if (!record) {
+            std::cout << "not found" << std::endl;
+            return EXIT_FAILURE;
+        }
+        Position stored;
+        stored.initialize(record->position);
+        std::cout << stored.asFEN() << std::endl;
+
+    } catch (const std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -6,6 +6,8 @@
 typedef std::int_fast8_t int8;
 typedef std::int_fast16_t int16;
 typedef std::uint_fast64_t uint64;
+typedef std::uint16_t uint16;
+typedef std::uint32_t uint32;
 
 /**
  * Gives the indices of the 8 directions in the NUM_SQUARES_TO_EDGE array
@@ -377,4 +379,12 @@ const uint64 ZOBRIST_KINGSIDE_CASTLING_KEYS[2] = {5362052560224176793ULL, 711706
  */
 const uint64 ZOBRIST_QUEENSIDE_CASTLING_KEYS[2] = {12085591603708853699ULL, 17859103354573023985ULL};
 
+/**
+ * Random 64 bit keys for denoting the file of the en passant target (only when an en passant capture is possible)
+ */
+const uint64 ZOBRIST_EN_PASSANT_KEYS[8] = {
+    17868092155144977276ULL, 17154658079713376834ULL, 763008174850138102ULL, 3233757099172882786ULL,
+    5682784987526353293ULL, 8122480007140980456ULL, 17103650564990940696ULL, 16102212137061632022ULL
+};
+
 #endif
\ No newline at end of file
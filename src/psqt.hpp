@@ -0,0 +1,200 @@
+#ifndef PSQT_H
+#define PSQT_H
+
+#include <cstdint>
+
+/**
+ * Material values of the peices (indexed by peice type, index 0 unused)
+ */
+constexpr int PEICE_VALUES[7] = {0, 100, 320, 330, 500, 900, 0};
+
+/**
+ * Contribution of every peice type to the game phase (24 at the start of the game, 0 with only kings and pawns)
+ */
+constexpr int PHASE_WEIGHTS[7] = {0, 0, 1, 1, 2, 4, 0};
+constexpr int MAX_PHASE = 24;
+
+/**
+ * Piece square tables for white from the white player's point of view (first row is the 8th rank)
+ * index with square ^ 56 for white peices and square for black peices
+ * second set of tables is used for the endgame (only the king differs)
+ */
+const int PEICE_SQUARE_TABLES[2][7][64] = {
+    {
+        {0},
+        { // PAWN
+              0,   0,   0,   0,   0,   0,   0,   0,
+             50,  50,  50,  50,  50,  50,  50,  50,
+             10,  10,  20,  30,  30,  20,  10,  10,
+              5,   5,  10,  25,  25,  10,   5,   5,
+              0,   0,   0,  20,  20,   0,   0,   0,
+              5,  -5, -10,   0,   0, -10,  -5,   5,
+              5,  10,  10, -20, -20,  10,  10,   5,
+              0,   0,   0,   0,   0,   0,   0,   0
+        },
+        { // KNIGHT
+            -50, -40, -30, -30, -30, -30, -40, -50,
+            -40, -20,   0,   0,   0,   0, -20, -40,
+            -30,   0,  10,  15,  15,  10,   0, -30,
+            -30,   5,  15,  20,  20,  15,   5, -30,
+            -30,   0,  15,  20,  20,  15,   0, -30,
+            -30,   5,  10,  15,  15,  10,   5, -30,
+            -40, -20,   0,   5,   5,   0, -20, -40,
+            -50, -40, -30, -30, -30, -30, -40, -50
+        },
+        { // BISHOP
+            -20, -10, -10, -10, -10, -10, -10, -20,
+            -10,   0,   0,   0,   0,   0,   0, -10,
+            -10,   0,   5,  10,  10,   5,   0, -10,
+            -10,   5,   5,  10,  10,   5,   5, -10,
+            -10,   0,  10,  10,  10,  10,   0, -10,
+            -10,  10,  10,  10,  10,  10,  10, -10,
+            -10,   5,   0,   0,   0,   0,   5, -10,
+            -20, -10, -10, -10, -10, -10, -10, -20
+        },
+        { // ROOK
+              0,   0,   0,   0,   0,   0,   0,   0,
+              5,  10,  10,  10,  10,  10,  10,   5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+              0,   0,   0,   5,   5,   0,   0,   0
+        },
+        { // QUEEN
+            -20, -10, -10,  -5,  -5, -10, -10, -20,
+            -10,   0,   0,   0,   0,   0,   0, -10,
+            -10,   0,   5,   5,   5,   5,   0, -10,
+             -5,   0,   5,   5,   5,   5,   0,  -5,
+              0,   0,   5,   5,   5,   5,   0,  -5,
+            -10,   5,   5,   5,   5,   5,   0, -10,
+            -10,   0,   5,   0,   0,   0,   0, -10,
+            -20, -10, -10,  -5,  -5, -10, -10, -20
+        },
+        { // KING
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -20, -30, -30, -40, -40, -30, -30, -20,
+            -10, -20, -20, -20, -20, -20, -20, -10,
+             20,  20,   0,   0,   0,   0,  20,  20,
+             20,  30,  10,   0,   0,  10,  30,  20
+        }
+    },
+    {
+        {0},
+        { // PAWN
+              0,   0,   0,   0,   0,   0,   0,   0,
+             80,  80,  80,  80,  80,  80,  80,  80,
+             50,  50,  50,  50,  50,  50,  50,  50,
+             30,  30,  30,  30,  30,  30,  30,  30,
+             20,  20,  20,  20,  20,  20,  20,  20,
+             10,  10,  10,  10,  10,  10,  10,  10,
+             10,  10,  10,  10,  10,  10,  10,  10,
+              0,   0,   0,   0,   0,   0,   0,   0
+        },
+        { // KNIGHT
+            -50, -40, -30, -30, -30, -30, -40, -50,
+            -40, -20,   0,   0,   0,   0, -20, -40,
+            -30,   0,  10,  15,  15,  10,   0, -30,
+            -30,   5,  15,  20,  20,  15,   5, -30,
+            -30,   0,  15,  20,  20,  15,   0, -30,
+            -30,   5,  10,  15,  15,  10,   5, -30,
+            -40, -20,   0,   5,   5,   0, -20, -40,
+            -50, -40, -30, -30, -30, -30, -40, -50
+        },
+        { // BISHOP
+            -20, -10, -10, -10, -10, -10, -10, -20,
+            -10,   0,   0,   0,   0,   0,   0, -10,
+            -10,   0,   5,  10,  10,   5,   0, -10,
+            -10,   5,   5,  10,  10,   5,   5, -10,
+            -10,   0,  10,  10,  10,  10,   0, -10,
+            -10,  10,  10,  10,  10,  10,  10, -10,
+            -10,   5,   0,   0,   0,   0,   5, -10,
+            -20, -10, -10, -10, -10, -10, -10, -20
+        },
+        { // ROOK
+              0,   0,   0,   0,   0,   0,   0,   0,
+              5,  10,  10,  10,  10,  10,  10,   5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+              0,   0,   0,   5,   5,   0,   0,   0
+        },
+        { // QUEEN
+            -20, -10, -10,  -5,  -5, -10, -10, -20,
+            -10,   0,   0,   0,   0,   0,   0, -10,
+            -10,   0,   5,   5,   5,   5,   0, -10,
+             -5,   0,   5,   5,   5,   5,   0,  -5,
+              0,   0,   5,   5,   5,   5,   0,  -5,
+            -10,   5,   5,   5,   5,   5,   0, -10,
+            -10,   0,   5,   0,   0,   0,   0, -10,
+            -20, -10, -10,  -5,  -5, -10, -10, -20
+        },
+        { // KING
+            -50, -40, -30, -20, -20, -30, -40, -50,
+            -30, -20, -10,   0,   0, -10, -20, -30,
+            -30, -10,  20,  30,  30,  20, -10, -30,
+            -30, -10,  30,  40,  40,  30, -10, -30,
+            -30, -10,  30,  40,  40,  30, -10, -30,
+            -30, -10,  20,  30,  30,  20, -10, -30,
+            -30, -30,   0,   0,   0,   0, -30, -30,
+            -50, -30, -30, -30, -30, -30, -30, -50
+        }
+    }
+};
+
+/**
+ * Middlegame and endgame scores packed in one int so a single addition updates both
+ * (endgame in the upper 16 bits, middlegame in the lower 16 bits, both signed)
+ */
+constexpr int makeScore(int middlegame, int endgame) noexcept
+{
+    return static_cast<int>(static_cast<unsigned>(endgame) << 16) + middlegame;
+}
+
+constexpr int middlegameScore(int score) noexcept
+{
+    return static_cast<std::int16_t>(static_cast<std::uint16_t>(static_cast<unsigned>(score)));
+}
+
+constexpr int endgameScore(int score) noexcept
+{
+    return static_cast<std::int16_t>(static_cast<std::uint16_t>((static_cast<unsigned>(score) + 0x8000) >> 16));
+}
+
+/**
+ * Material plus piece square score of every peice and color on every square from white's point of view
+ * (indexed by peice value and square, black peices score negative), the feature weights of the incremental evaluation
+ */
+struct PeiceSquareScores
+{
+    int score[15][64];
+
+    int phase[15];
+
+    PeiceSquareScores() : score(), phase()
+    {
+        for (int c = 0; c < 2; ++c) {
+            int sign = c ? -1 : 1;
+            int flip = c ? 0 : 56;
+            for (int type = 1; type <= 6; ++type) {
+                int peice = (c << 3) + type;
+                phase[peice] = PHASE_WEIGHTS[type];
+                for (int square = 0; square < 64; ++square) {
+                    int s = square ^ flip;
+                    score[peice][square] = makeScore(sign * (PEICE_VALUES[type] + PEICE_SQUARE_TABLES[0][type][s]),
+                                                     sign * (PEICE_VALUES[type] + PEICE_SQUARE_TABLES[1][type][s]));
+                }
+            }
+        }
+    }
+};
+
+inline const PeiceSquareScores PSQT;
+
+#endif
@@ -0,0 +1,483 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstdlib>
+
+#include "MappedFile.hpp"
+#include "Search.hpp"
+#include "Stats.hpp"
+#include "Tablebases.hpp"
+#include "ThreadPool.hpp"
+#include "arguments.hpp"
+#include "pgn.hpp"
+
+static void printUsage()
+{
+    std::cout << "usage: selfplay [options]   play games between two configurations of the engine (A and B)\n"
+              << "options:\n"
+              << "       --games <n>          games to play (default 100), every opening is played twice with the colors swapped\n"
+              << "       --concurrency <n>    games played at once (0 uses every hardware thread, default 0)\n"
+              << "       --openings <file>    epd file of start positions (default the starting position)\n"
+              << "       --random-plies <n>   random moves played from the opening before the engines take over (default 0)\n"
+              << "       --a <limits>         per move limits of A, ex nodes=20000 or depth=6,movetime=200 (default nodes=20000)\n"
+              << "       --b <limits>         per move limits of B (default the limits of A)\n"
+              << "       --hash <mb>          transposition table of every engine (default 8)\n"
+              << "       --max-plies <n>      adjudicate a draw after n half moves (default 400)\n"
+              << "       --sprt <elo0>,<elo1> stop once A is shown to be elo0 (H0) or elo1 (H1) stronger than B\n"
+              << "       --alpha <p>          false positive rate of the sprt (default 0.05)\n"
+              << "       --beta <p>           false negative rate of the sprt (default 0.05)\n"
+              << "       --pgn <file>         write every game\n"
+              << "       --syzygy <dirs>      adjudicate tablebase endgames and probe them in the search (when built with Fathom)\n"
+              << "       --json <file>        also write the results and the performance counters as json\n";
+}
+
+// Per move search limits, ex "nodes=20000,depth=8,movetime=100"
+static SearchLimits parseLimits(const std::string &spec)
+{
+    SearchLimits limits;
+    std::size_t start = 0;
+    while (start < spec.size()) {
+        std::size_t end = std::min(spec.find(',', start), spec.size());
+        std::string item = spec.substr(start, end - start);
+        std::size_t equals = item.find('=');
+        if (equals == std::string::npos) {
+            throw std::invalid_argument("Limits should be written as name=value, found " + item + "!");
+        }
+        std::string name = item.substr(0, equals);
+        long long value = std::stoll(item.substr(equals + 1));
+        if (name == "nodes") {
+            limits.nodes = static_cast<uint64>(value);
+        } else if (name == "depth") {
+            limits.depth = static_cast<int>(value);
+        } else if (name == "movetime") {
+            limits.hardTime = value;
+        } else {
+            throw std::invalid_argument("Unknown limit " + name + "!");
+        }
+        start = end + 1;
+    }
+    if (!limits.nodes && !limits.depth && !limits.hardTime) {
+        throw std::invalid_argument("Limits should set nodes, depth or movetime!");
+    }
+    return limits;
+}
+
+// Games won, drawn and lost by A, with the elo estimate and the sprt log likelihood ratio
+struct Tally
+{
+    int wins = 0;
+
+    int draws = 0;
+
+    int losses = 0;
+
+    int games() const noexcept
+    {
+        return wins + draws + losses;
+    }
+
+    // mean score of A per game
+    double score() const noexcept
+    {
+        return games() ? (wins + 0.5 * draws) / games() : 0.5;
+    }
+
+    // variance of the score of a single game
+    double variance() const noexcept
+    {
+        double mean = score();
+        return games() ? (wins * (1 - mean) * (1 - mean) + draws * (0.5 - mean) * (0.5 - mean) + losses * mean * mean) / games() : 0;
+    }
+
+    static double elo(double score) noexcept
+    {
+        score = std::clamp(score, 1e-6, 1 - 1e-6);
+        return -400 * std::log10(1 / score - 1);
+    }
+
+    static double expectedScore(double elo) noexcept
+    {
+        return 1 / (1 + std::pow(10, -elo / 400));
+    }
+
+    // half width of the 95% confidence interval of the elo estimate
+    double eloError() const noexcept
+    {
+        if (!games()) {
+            return 0;
+        }
+        double error = 1.96 * std::sqrt(variance() / games());
+        return (elo(score() + error) - elo(score() - error)) / 2;
+    }
+
+    // log likelihood ratio of H1 (A is elo1 stronger) against H0 (A is elo0 stronger), normal approximation of the game scores
+    double llr(double elo0, double elo1) const noexcept
+    {
+        double var = variance();
+        if (var <= 0) {
+            return 0;
+        }
+        double s0 = expectedScore(elo0);
+        double s1 = expectedScore(elo1);
+        return games() * (s1 - s0) * (2 * score() - s0 - s1) / (2 * var);
+    }
+};
+
+// One side of the games: its limits and a search with its own transposition table per worker
+struct EngineConfig
+{
+    std::string name;
+
+    SearchLimits limits;
+};
+
+struct Engine
+{
+    TranspositionTable tt;
+
+    Search search;
+
+    Engine(std::size_t hashMegabytes, Tablebases *tablebases) : tt(hashMegabytes), search(tt)
+    {
+        search.setTablebases(tablebases);
+    }
+};
+
+// A finished game
+struct Game
+{
+    // 1 if white won, -1 if black won, 0 for a draw
+    int result;
+
+    bool adjudicated;
+
+    // nodes searched by both engines
+    uint64 nodes;
+
+    // hash of the moves played, equal for the two games of a pair when A and B played the same moves
+    uint64 movesKey;
+
+    std::string pgn;
+};
+
+static const char *resultString(int result)
+{
+    return result > 0 ? "1-0" : result < 0 ? "0-1" : "1/2-1/2";
+}
+
+struct SelfPlayOptions
+{
+    EngineConfig engines[2];
+
+    std::vector<std::string> openings;
+
+    int randomPlies;
+
+    int maxPlies;
+
+    Tablebases *tablebases;
+};
+
+/**
+ * Play game number index: pairs of games play the same opening, A has white in even games
+ * @param engines search of A and B (index 0 and 1)
+ */
+static Game playGame(int index, const SelfPlayOptions &options, Engine *engines[2])
+{
+    int pair = index / 2;
+    int white = index % 2;
+    Position position(options.openings[static_cast<std::size_t>(pair) % options.openings.size()]);
+    Position start = position;
+    std::vector<Position::Move> moves;
+
+    for (Engine *engine : {engines[0], engines[1]}) {
+        engine->tt.clear();
+        engine->search.clearHistory();
+    }
+
+    // Both games of a pair get the same random moves
+    std::mt19937 random(static_cast<unsigned>(pair));
+    for (int ply = 0; ply < options.randomPlies && !position.gameOver().has_value(); ++ply) {
+        Position::MoveList legal = position.legalMoves();
+        Position::Move move = legal[static_cast<int>(random() % static_cast<unsigned>(legal.size()))];
+        position.makeMove(move);
+        moves.push_back(move);
+    }
+
+    std::optional<int> result;
+    bool adjudicated = false;
+    uint64 nodes = 0;
+    while (!(result = position.gameOver()).has_value()) {
+        if (options.tablebases && position.halfmoveClock() == 0) {
+            if (std::optional<Tablebases::Wdl> wdl = options.tablebases->probeWdl(position)) {
+                int sign = position.sideToMove() ? -1 : 1;
+                result = wdl.value() == Tablebases::WIN ? sign : wdl.value() == Tablebases::LOSS ? -sign : 0;
+                adjudicated = true;
+                break;
+            }
+        }
+        if (static_cast<int>(moves.size()) >= options.maxPlies) {
+            result = 0;
+            adjudicated = true;
+            break;
+        }
+
+        int side = position.sideToMove() ^ white;
+        SearchInfo info = engines[side]->search.run(position, options.engines[side].limits);
+        nodes += info.nodes;
+        position.makeMove(info.pv[0]);
+        moves.push_back(info.pv[0]);
+    }
+
+    std::vector<std::pair<std::string, std::string>> tags = {
+        {"Event", "selfplay"},
+        {"Site", "?"},
+        {"Date", "????.??.??"},
+        {"Round", std::to_string(index + 1)},
+        {"White", options.engines[white].name},
+        {"Black", options.engines[!white].name},
+        {"Result", resultString(result.value())},
+        {"Termination", adjudicated ? "adjudication" : "normal"},
+    };
+    uint64 movesKey = 0;
+    for (const Position::Move &move : moves) {
+        movesKey = (movesKey ^ move.compact()) * 0x100000001B3ULL;
+    }
+    return Game{result.value(), adjudicated, nodes, movesKey, writePgnGame(tags, start, moves, resultString(result.value()))};
+}
+
+int main(int argc, char *argv[])
+{
+    int games = 100;
+    int concurrency = 0;
+    std::size_t hashMegabytes = 8;
+    std::string openingsPath;
+    std::string pgnPath;
+    std::string syzygyPath;
+    std::string jsonPath;
+    std::string limits[2] = {"nodes=20000", ""};
+    bool sprt = false;
+    double elo0 = 0;
+    double elo1 = 5;
+    double alpha = 0.05;
+    double beta = 0.05;
+    SelfPlayOptions options;
+    options.randomPlies = 0;
+    options.maxPlies = 400;
+    options.tablebases = nullptr;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--help" || i + 1 >= argc) {
+                printUsage();
+                return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+            std::string value = argv[++i];
+            if (arg == "--games") {
+                games = std::max(1, parseNumber(arg, value));
+            } else if (arg == "--concurrency") {
+                concurrency = parseNumber(arg, value);
+            } else if (arg == "--openings") {
+                openingsPath = value;
+            } else if (arg == "--random-plies") {
+                options.randomPlies = std::max(0, parseNumber(arg, value));
+            } else if (arg == "--a" || arg == "--b") {
+                limits[arg == "--b"] = value;
+            } else if (arg == "--hash") {
+                hashMegabytes = static_cast<std::size_t>(std::max(1, parseNumber(arg, value)));
+            } else if (arg == "--max-plies") {
+                options.maxPlies = std::max(1, parseNumber(arg, value));
+            } else if (arg == "--sprt") {
+                std::size_t comma = value.find(',');
+                if (comma == std::string::npos) {
+                    throw std::invalid_argument("Sprt bounds should be written as elo0,elo1!");
+                }
+                elo0 = parseDecimal(arg, value.substr(0, comma));
+                elo1 = parseDecimal(arg, value.substr(comma + 1));
+                sprt = true;
+            } else if (arg == "--alpha") {
+                alpha = parseDecimal(arg, value);
+            } else if (arg == "--beta") {
+                beta = parseDecimal(arg, value);
+            } else if (arg == "--pgn") {
+                pgnPath = value;
+            } else if (arg == "--syzygy") {
+                syzygyPath = value;
+            } else if (arg == "--json") {
+                jsonPath = value;
+            } else {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        }
+        if (limits[1].empty()) {
+            limits[1] = limits[0];
+        }
+        for (int i = 0; i < 2; ++i) {
+            options.engines[i] = EngineConfig{std::string(i ? "B" : "A") + " (" + limits[i] + ")", parseLimits(limits[i])};
+        }
+
+        if (openingsPath.empty()) {
+            options.openings.push_back("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        } else {
+            MappedFile file(openingsPath);
+            std::string_view rest = file.data();
+            std::size_t line = 1;
+            std::string_view epd;
+            Position position;
+            while (nextEpdLine(rest, line, epd)) {
+                try {
+                    loadEpd(epd, position);
+                    validatePosition(position);
+                    if (!position.gameOver().has_value()) {
+                        options.openings.push_back(position.asFEN());
+                    }
+                } catch (const std::exception &e) {
+                    std::cerr << openingsPath << ":" << line << ": " << e.what() << "\n";
+                }
+                ++line;
+            }
+            if (options.openings.empty()) {
+                throw std::runtime_error(openingsPath + " has no playable positions!");
+            }
+        }
+
+        Tablebases tablebases;
+        if (!syzygyPath.empty()) {
+            if (tablebases.load(syzygyPath)) {
+                options.tablebases = &tablebases;
+            } else {
+                std::cerr << (Tablebases::available() ? "no tablebases found in " + syzygyPath : std::string("built without tablebase support")) << std::endl;
+            }
+        }
+
+        std::ofstream pgn;
+        if (!pgnPath.empty()) {
+            pgn.open(pgnPath, std::ios::binary);
+            if (!pgn) {
+                throw std::runtime_error("Cannot open " + pgnPath + "!");
+            }
+        }
+
+        // SPRT bounds on the log likelihood ratio
+        double lowerBound = std::log(beta / (1 - alpha));
+        double upperBound = std::log((1 - beta) / alpha);
+
+        ThreadPool pool(concurrency);
+        std::atomic<int> nextGame(0);
+        std::atomic<bool> decided(false);
+        std::mutex mutex;
+        Tally tally;
+        int adjudicated = 0;
+        uint64 nodes = 0;
+        // moves of the first finished game of every pair, a pair whose second game repeats them is identical
+        std::unordered_map<int, uint64> pairMoves;
+        int pairs = 0;
+        int identicalPairs = 0;
+        std::string verdict;
+        auto start = std::chrono::steady_clock::now();
+
+        std::cout << "games " << games << "  concurrency " << pool.size() << "  openings " << options.openings.size()
+                  << "  A " << options.engines[0].name << "  B " << options.engines[1].name << std::endl;
+
+        // Every worker keeps its own pair of engines and takes the next game until all are played or the sprt decides
+        for (int worker = 0; worker < pool.size(); ++worker) {
+            pool.submit([&] {
+                Engine a(hashMegabytes, options.tablebases);
+                Engine b(hashMegabytes, options.tablebases);
+                Engine *engines[2] = {&a, &b};
+                for (int index; !decided.load() && (index = nextGame.fetch_add(1)) < games; ) {
+                    Game game = playGame(index, options, engines);
+
+                    // result from the point of view of A (white in even games)
+                    int score = index % 2 ? -game.result : game.result;
+                    std::lock_guard<std::mutex> lock(mutex);
+                    tally.wins += score > 0;
+                    tally.draws += score == 0;
+                    tally.losses += score < 0;
+                    adjudicated += game.adjudicated;
+                    nodes += game.nodes;
+                    auto [first, inserted] = pairMoves.emplace(index / 2, game.movesKey);
+                    if (!inserted) {
+                        ++pairs;
+                        identicalPairs += first->second == game.movesKey;
+                        pairMoves.erase(first);
+                    }
+                    if (pgn.is_open()) {
+                        pgn << game.pgn;
+                    }
+
+                    std::cout << "game " << tally.games() << "/" << games << "  " << resultString(game.result)
+                              << "  A " << tally.wins << " - " << tally.losses << " - " << tally.draws
+                              << "  elo " << std::fixed << std::setprecision(1) << Tally::elo(tally.score()) << " +- " << tally.eloError();
+                    if (sprt) {
+                        double llr = tally.llr(elo0, elo1);
+                        std::cout << "  llr " << std::setprecision(2) << llr << " (" << lowerBound << ", " << upperBound << ")";
+                        if (!decided && (llr <= lowerBound || llr >= upperBound)) {
+                            decided = true;
+                            verdict = llr >= upperBound ? "H1" : "H0";
+                            std::cout << "\nsprt accepts " << verdict;
+                        }
+                    }
+                    std::cout << std::endl;
+                }
+            });
+        }
+        pool.wait();
+
+        std::cout << "A " << tally.wins << " - " << tally.losses << " - " << tally.draws << " (wins - losses - draws)"
+                  << "  adjudicated " << adjudicated
+                  << "  score " << std::fixed << std::setprecision(3) << tally.score()
+                  << "  elo " << std::setprecision(1) << Tally::elo(tally.score()) << " +- " << tally.eloError() << std::endl;
+        std::cout << "identical pairs " << identicalPairs << "/" << pairs << std::endl;
+        // Different limits that never change a move (ex node limits too close together) make the elo meaningless
+        if (pairs && identicalPairs == pairs && limits[0] != limits[1]) {
+            std::cerr << "warning: A and B played the same moves with colors swapped in every pair, their limits don't change the games" << std::endl;
+        }
+
+        if (!jsonPath.empty()) {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            JsonObject report;
+            report.add("a", options.engines[0].name)
+                  .add("b", options.engines[1].name)
+                  .add("games", tally.games())
+                  .add("wins", tally.wins)
+                  .add("losses", tally.losses)
+                  .add("draws", tally.draws)
+                  .add("adjudicated", adjudicated)
+                  .add("score", tally.score())
+                  .add("elo", Tally::elo(tally.score()))
+                  .add("elo_error", tally.eloError())
+                  .add("pairs", pairs)
+                  .add("identical_pairs", identicalPairs);
+            if (sprt) {
+                report.add("llr", tally.llr(elo0, elo1)).add("sprt", verdict.empty() ? std::string("undecided") : verdict);
+            }
+            report.add("nodes", nodes)
+                  .add("seconds", seconds)
+                  .add("nps", static_cast<uint64>(seconds > 0 ? nodes / seconds : 0))
+                  .add("concurrency", pool.size())
+                  .add("stats", statsJson())
+                  .write(jsonPath);
+        }
+
+    } catch (const std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
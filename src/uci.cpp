@@ -0,0 +1,355 @@
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <cstdlib>
+
+#include "ParallelSearch.hpp"
+#include "PolyglotBook.hpp"
+
+/**
+ * Universal Chess Interface front-end: reads commands from stdin and writes responses to stdout
+ * The search runs on its own thread so stop / isready are handled while searching
+ */
+class UciEngine
+{
+public:
+    UciEngine() : tt(DEFAULT_HASH), search(tt, 1)
+    {
+        search.setTablebases(&tablebases);
+    }
+
+    ~UciEngine()
+    {
+        stopSearch();
+    }
+
+    // Handle commands until quit or the end of input
+    void loop(std::istream &in)
+    {
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!handle(line)) {
+                break;
+            }
+        }
+    }
+
+private:
+    static constexpr int DEFAULT_HASH = 16;
+    static constexpr int MAX_HASH = 65536;
+    static constexpr int MAX_THREADS = 256;
+
+    TranspositionTable tt;
+
+    ParallelSearch search;
+
+    Tablebases tablebases;
+
+    Position position;
+
+    std::thread searcher;
+
+    // true from go until the search itself has finished (the thread may still be holding its best move)
+    std::atomic<bool> searching{false};
+
+    // set by stop / quit, the best move of go infinite and go ponder is only sent once it is set
+    bool stopRequested = false;
+    // set by ponderhit, the held best move of the ponder search is dropped instead of sent
+    bool discardResult = false;
+    std::mutex stopMutex;
+    std::condition_variable stopSignal;
+
+    // true between go ponder and ponderhit / stop, the limits of the go command apply from ponderhit on
+    bool pondering = false;
+    SearchLimits ponderLimits;
+
+    // polyglot book probed before searching (when OwnBook is set and both book files are given)
+    std::unique_ptr<PolyglotBook> book;
+
+    std::string bookFile, bookKeys;
+
+    bool ownBook = false;
+
+    std::mt19937 random{std::random_device{}()};
+
+    // guards stdout between the search thread and the command thread
+    std::mutex output;
+
+    void send(const std::string &message)
+    {
+        std::lock_guard<std::mutex> lock(output);
+        std::cout << message << std::endl;
+    }
+
+    // Stop the running search and wait for it to print its best move (or drop the move if discard is set)
+    // (a search that already finished is only joined, so the stop doesn't carry over to the next go)
+    void stopSearch(bool discard = false)
+    {
+        pondering = false;
+        if (searcher.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(stopMutex);
+                stopRequested = true;
+                discardResult = discard;
+            }
+            stopSignal.notify_all();
+            if (searching.load()) {
+                search.stop();
+            }
+            searcher.join();
+        }
+    }
+
+    // @return false if the engine should quit
+    bool handle(const std::string &line)
+    {
+        std::istringstream tokens(line);
+        std::string command;
+        if (!(tokens >> command)) {
+            return true;
+        }
+
+        try {
+            if (command == "uci") {
+                send("id name chessgui\nid author chessgui\n"
+                     "option name Hash type spin default " + std::to_string(DEFAULT_HASH) + " min 1 max " + std::to_string(MAX_HASH) + "\n"
+                     "option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS) + "\n"
+                     "option name Ponder type check default false\n"
+                     "option name OwnBook type check default false\n"
+                     "option name BookFile type string default <empty>\n"
+                     "option name BookKeys type string default <empty>\n"
+                     + std::string(Tablebases::available() ? "option name SyzygyPath type string default <empty>\n" : "") +
+                     "uciok");
+            } else if (command == "isready") {
+                send("readyok");
+            } else if (command == "setoption") {
+                stopSearch();
+                setOption(tokens);
+            } else if (command == "ucinewgame") {
+                stopSearch();
+                tt.clear();
+                search.clearHistory();
+            } else if (command == "position") {
+                stopSearch();
+                setPosition(tokens);
+            } else if (command == "go") {
+                stopSearch();
+                go(tokens);
+            } else if (command == "ponderhit") {
+                // The opponent played the expected move: search it for real with the limits of go ponder
+                if (pondering) {
+                    SearchLimits limits = ponderLimits;
+                    stopSearch(true);
+                    startSearch(limits, false);
+                }
+            } else if (command == "stop") {
+                stopSearch();
+            } else if (command == "quit") {
+                stopSearch();
+                return false;
+            } else if (command == "d") {
+                send(position.asFEN());
+            } else {
+                send("info string unknown command " + command);
+            }
+        } catch (const std::exception &e) {
+            send(std::string("info string error: ") + e.what());
+        }
+        return true;
+    }
+
+    // setoption name <name> value <value>
+    void setOption(std::istringstream &tokens)
+    {
+        std::string token, name, value;
+        tokens >> token;
+        while (tokens >> token && token != "value") {
+            name += (name.empty() ? "" : " ") + token;
+        }
+        // the value is the rest of the line (paths may contain spaces)
+        std::getline(tokens >> std::ws, value);
+
+        if (name == "Hash") {
+            tt.resize(static_cast<std::size_t>(std::clamp(std::stoi(value), 1, MAX_HASH)));
+        } else if (name == "Threads") {
+            search.setThreads(std::clamp(std::stoi(value), 1, MAX_THREADS));
+        } else if (name == "SyzygyPath") {
+            if (tablebases.load(value == "<empty>" ? "" : value)) {
+                send("info string tablebases up to " + std::to_string(tablebases.largest()) + " peices");
+            }
+        } else if (name == "Ponder") {
+            // only tells whether the gui may send go ponder, which is always supported
+        } else if (name == "OwnBook") {
+            ownBook = value == "true";
+        } else if (name == "BookFile" || name == "BookKeys") {
+            (name == "BookFile" ? bookFile : bookKeys) = value == "<empty>" ? "" : value;
+            loadBook();
+        } else {
+            send("info string unknown option " + name);
+        }
+    }
+
+    // Open the book once both files are known
+    void loadBook()
+    {
+        book.reset();
+        if (bookFile.empty() || bookKeys.empty()) {
+            return;
+        }
+        book = std::make_unique<PolyglotBook>(bookFile, bookKeys);
+        if (!book->polyglotKeys().isStandard()) {
+            send("info string " + bookKeys + " is not the standard Random64 table, books made by polyglot will not match");
+        }
+    }
+
+    // position [startpos | fen <fen>] [moves <move>...]
+    void setPosition(std::istringstream &tokens)
+    {
+        std::string token, fen;
+        tokens >> token;
+        if (token == "startpos") {
+            fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+            tokens >> token;
+        } else if (token == "fen") {
+            while (tokens >> token && token != "moves") {
+                fen += (fen.empty() ? "" : " ") + token;
+            }
+        } else {
+            throw std::invalid_argument("position should be followed by startpos or fen");
+        }
+
+        position.initialize(fen);
+        if (token == "moves") {
+            while (tokens >> token) {
+                position.makeMove(position.moveFromString(token));
+            }
+        }
+    }
+
+    // go [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>] [depth <n>] [nodes <n>] [movetime <ms>] [infinite] [ponder]
+    // other tokens (searchmoves, mate, ...) are skipped
+    void go(std::istringstream &tokens)
+    {
+        SearchLimits limits;
+        int64_t time[2] = {0, 0};
+        int64_t increment[2] = {0, 0};
+        int movesToGo = 0;
+        int64_t moveTime = 0;
+        bool infinite = false;
+        bool ponder = false;
+
+        std::string token;
+        while (tokens >> token) {
+            if (token == "infinite" || token == "ponder") {
+                (token == "infinite" ? infinite : ponder) = true;
+                continue;
+            }
+            if (token != "wtime" && token != "btime" && token != "winc" && token != "binc" && token != "movestogo"
+                && token != "movetime" && token != "depth" && token != "nodes") {
+                continue;
+            }
+            long long value;
+            if (!(tokens >> value)) {
+                throw std::invalid_argument("go " + token + " should be followed by a number");
+            }
+            if (token == "wtime") time[0] = value;
+            else if (token == "btime") time[1] = value;
+            else if (token == "winc") increment[0] = value;
+            else if (token == "binc") increment[1] = value;
+            else if (token == "movestogo") movesToGo = static_cast<int>(value);
+            else if (token == "movetime") moveTime = value;
+            else if (token == "depth") limits.depth = static_cast<int>(value);
+            else if (token == "nodes") limits.nodes = static_cast<uint64>(value);
+        }
+
+        // Book moves are played without searching (except for infinite analysis and pondering)
+        if (ownBook && book && !infinite && !ponder) {
+            std::optional<Position::Move> move = book->probe(position, random() | 1);
+            if (move.has_value()) {
+                send("info string book move\nbestmove " + move->toString());
+                return;
+            }
+        }
+
+        int side = position.sideToMove();
+        if (moveTime) {
+            limits.hardTime = moveTime;
+        } else if (time[side]) {
+            SearchLimits clock = SearchLimits::fromClock(time[side], increment[side], movesToGo);
+            limits.softTime = clock.softTime;
+            limits.hardTime = clock.hardTime;
+        }
+
+        // A ponder search runs until ponderhit or stop, the clock only starts at ponderhit
+        if (ponder) {
+            startSearch(SearchLimits(), true);
+            pondering = true;
+            ponderLimits = limits;
+            return;
+        }
+        startSearch(limits, infinite);
+    }
+
+    /**
+     * Search the current position on the search thread
+     * @param hold keep the best move until stop (go infinite and go ponder must not send it earlier, even if the search ends)
+     */
+    void startSearch(const SearchLimits &limits, bool hold)
+    {
+        stopRequested = false;
+        discardResult = false;
+        search.clearStop();
+        searching.store(true);
+        searcher = std::thread([this, limits, hold, root = position] {
+            SearchInfo result = search.run(root, limits, [this](const SearchInfo &info) {
+                send(infoString(info));
+            });
+            searching.store(false);
+            {
+                std::unique_lock<std::mutex> lock(stopMutex);
+                if (hold) {
+                    stopSignal.wait(lock, [this] { return stopRequested; });
+                }
+                if (discardResult) {
+                    return;
+                }
+            }
+            send(result.pv.empty() ? "bestmove 0000" : "bestmove " + result.pv[0].toString());
+        });
+    }
+
+    std::string infoString(const SearchInfo &info) const
+    {
+        std::string str = "info depth " + std::to_string(info.depth) + " seldepth " + std::to_string(info.selectiveDepth);
+        if (Search::isMateScore(info.score)) {
+            int plies = Search::MATE - std::abs(info.score);
+            str += " score mate " + std::to_string(info.score > 0 ? (plies + 1) / 2 : -(plies + 1) / 2);
+        } else {
+            str += " score cp " + std::to_string(info.score);
+        }
+        uint64 milliseconds = static_cast<uint64>(info.seconds * 1000);
+        str += " nodes " + std::to_string(info.nodes)
+             + " nps " + std::to_string(milliseconds ? info.nodes * 1000 / milliseconds : 0)
+             + " time " + std::to_string(milliseconds)
+             + " hashfull " + std::to_string(tt.hashfull())
+             + " pv";
+        for (const Position::Move &move : info.pv) {
+            str += " " + move.toString();
+        }
+        return str;
+    }
+};
+
+int main()
+{
+    std::ios::sync_with_stdio(false);
+    UciEngine engine;
+    engine.loop(std::cin);
+    return EXIT_SUCCESS;
+}